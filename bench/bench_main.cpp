@@ -0,0 +1,1815 @@
+// 无窗口的性能测试程序：不创建 OpenGL 上下文，只测 CPU 侧逻辑
+// 用法：MyMinecraftBench [选项] [测试名...]，不带测试名时运行全部测试
+//   --radius N    world 测试的世界半径（区块），默认 8
+//   --seed S      world 测试的世界种子，默认 0
+//   --repeats N   world 测试每项重复的轮数，默认 5
+//   --json PATH   把带统计的结果（min/median/p99）写成 JSON，便于比较不同的运行
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "Chunk.h"
+#include "ChunkIO.h"
+#include "ChunkMap.h"
+#include "ChunkPipeline.h"
+#include "ChunkStreamer.h"
+#include "DayCycle.h"
+#include "Frustum.h"
+#include "LightEngine.h"
+#include "PerlinBatch.h"
+#include "Player.h"
+#include "Profiler.h"
+#include "Raycast.h"
+#include "WorldStorage.h"
+#include <stb_perlin.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+using BenchClock = std::chrono::steady_clock;
+
+// 防止编译器把测试循环优化掉
+static volatile uintptr_t g_sink = 0;
+
+static double elapsedNs(BenchClock::time_point start) {
+    return std::chrono::duration<double, std::nano>(BenchClock::now() - start).count();
+}
+
+// 命令行选项（main 中解析）
+struct BenchOptions {
+    int worldRadius = 8;
+    uint32_t seed = 0;
+    int repeats = 5;
+    std::string jsonPath;
+};
+static BenchOptions g_options;
+
+// 一项测量的统计：样本为单次操作的耗时（纳秒），吞吐量按平均耗时计算
+struct BenchResult {
+    std::string bench;
+    std::string metric;
+    size_t samples = 0;
+    double minNs = 0.0, medianNs = 0.0, p99Ns = 0.0, meanNs = 0.0;
+    double opsPerSecond = 0.0;
+};
+static std::vector<BenchResult> g_results;
+
+// 统计、打印并记录（写 JSON 用）一组样本
+static void reportSamples(const char* bench, const char* metric, std::vector<double> samplesNs) {
+    if (samplesNs.empty()) {
+        return;
+    }
+    std::sort(samplesNs.begin(), samplesNs.end());
+    BenchResult result;
+    result.bench = bench;
+    result.metric = metric;
+    result.samples = samplesNs.size();
+    result.minNs = samplesNs.front();
+    result.medianNs = samplesNs[samplesNs.size() / 2];
+    result.p99Ns = samplesNs[samplesNs.size() * 99 / 100];
+    double total = 0.0;
+    for (double ns : samplesNs) {
+        total += ns;
+    }
+    result.meanNs = total / samplesNs.size();
+    result.opsPerSecond = 1e9 / result.meanNs;
+    std::cout << "  " << metric << ": min " << result.minNs << " ns, median " << result.medianNs << " ns, p99 "
+              << result.p99Ns << " ns (" << result.opsPerSecond / 1e3 << " K/s, " << result.samples
+              << " samples)\n";
+    g_results.push_back(result);
+}
+
+static bool writeResultsJson(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    out << "{\n  \"config\": {\"radius\": " << g_options.worldRadius << ", \"seed\": " << g_options.seed
+        << ", \"repeats\": " << g_options.repeats << ", \"threads\": " << ThreadPool::defaultThreadCount()
+        << "},\n  \"results\": [";
+    for (size_t i = 0; i < g_results.size(); i++) {
+        const BenchResult& r = g_results[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"bench\": \"" << r.bench << "\", \"metric\": \"" << r.metric
+            << "\", \"samples\": " << r.samples << ", \"min_ns\": " << r.minNs << ", \"median_ns\": "
+            << r.medianNs << ", \"p99_ns\": " << r.p99Ns << ", \"mean_ns\": " << r.meanNs
+            << ", \"ops_per_second\": " << r.opsPerSecond << "}";
+    }
+    out << "\n  ]\n}\n";
+    return (bool)out;
+}
+
+// ---------------------------------------------------------------------------
+// ChunkMap 与 std::map 查找开销对比
+// ---------------------------------------------------------------------------
+
+// 随机查找：坐标均匀分布在已加载范围内（外加少量未加载的坐标）
+// 连续查找：模拟 checkCollision，玩家缓慢移动，每帧查询周围 2x3x2 个方块
+static void benchChunkMapAt(int renderDistance) {
+    const int side = 2 * renderDistance + 1;
+    std::vector<Chunk*> pool;
+    std::map<std::pair<int, int>, Chunk*> treeMap;
+    ChunkMap hashMap;
+    for (int cx = -renderDistance; cx <= renderDistance; cx++) {
+        for (int cz = -renderDistance; cz <= renderDistance; cz++) {
+            Chunk* chunk = new Chunk();
+            pool.push_back(chunk);
+            treeMap[{cx, cz}] = chunk;
+            hashMap.insert(cx, cz, chunk);
+        }
+    }
+
+    const int LOOKUPS = 2000000;
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<int> dist(-renderDistance - 1, renderDistance + 1);
+    std::vector<std::pair<int, int>> randomKeys(LOOKUPS);
+    for (auto& key : randomKeys) {
+        key = {dist(rng), dist(rng)};
+    }
+
+    // 连续访问：把方块坐标换算成区块坐标，与 Player::isBlockSolid 一致
+    std::vector<std::pair<int, int>> coherentKeys;
+    coherentKeys.reserve(LOOKUPS);
+    float px = 0.0f, pz = 0.0f;
+    while ((int)coherentKeys.size() < LOOKUPS) {
+        px += 0.11f;
+        pz += 0.07f;
+        int bx = (int)std::floor(px) % (renderDistance * 16);
+        int bz = (int)std::floor(pz) % (renderDistance * 16);
+        for (int dx = 0; dx < 2; dx++) {
+            for (int dy = 0; dy < 3; dy++) {
+                for (int dz = 0; dz < 2; dz++) {
+                    int x = bx + dx, z = bz + dz;
+                    int chunkX = (x >= 0) ? x / 16 : (x - 15) / 16;
+                    int chunkZ = (z >= 0) ? z / 16 : (z - 15) / 16;
+                    coherentKeys.push_back({chunkX, chunkZ});
+                }
+            }
+        }
+    }
+    coherentKeys.resize(LOOKUPS);
+
+    auto runTree = [&](const std::vector<std::pair<int, int>>& keys) {
+        auto start = BenchClock::now();
+        uintptr_t acc = 0;
+        for (const auto& key : keys) {
+            auto it = treeMap.find(key);
+            acc += (it != treeMap.end()) ? (uintptr_t)it->second : 0;
+        }
+        g_sink += acc;
+        return elapsedNs(start) / keys.size();
+    };
+    auto runHash = [&](const std::vector<std::pair<int, int>>& keys) {
+        auto start = BenchClock::now();
+        uintptr_t acc = 0;
+        for (const auto& key : keys) {
+            acc += (uintptr_t)hashMap.find(key.first, key.second);
+        }
+        g_sink += acc;
+        return elapsedNs(start) / keys.size();
+    };
+
+    double treeRandom = runTree(randomKeys);
+    double hashRandom = runHash(randomKeys);
+    double treeCoherent = runTree(coherentKeys);
+    double hashCoherent = runHash(coherentKeys);
+
+    std::cout << "  " << side * side << " chunks:\n"
+              << "    random   std::map " << treeRandom << " ns/lookup, ChunkMap "
+              << hashRandom << " ns/lookup (" << treeRandom / hashRandom << "x)\n"
+              << "    coherent std::map " << treeCoherent << " ns/lookup, ChunkMap "
+              << hashCoherent << " ns/lookup (" << treeCoherent / hashCoherent << "x)\n";
+
+    for (Chunk* chunk : pool) {
+        delete chunk;
+    }
+}
+
+static void benchChunkMap() {
+    benchChunkMapAt(8);    // 17x17 = 289 个区块（默认渲染距离）
+    benchChunkMapAt(50);   // 101x101 = 10201 个区块
+}
+
+// ---------------------------------------------------------------------------
+// 逐面网格与贪婪网格对比（默认渲染距离下的柏林噪声地形）
+// ---------------------------------------------------------------------------
+
+static void benchMeshing() {
+    const int renderDistance = 8;
+    std::vector<Chunk*> chunks;
+    ChunkMap registry;   // 注册后相邻指针就绪，边界面按相邻区块剔除
+    for (int cx = -renderDistance; cx <= renderDistance; cx++) {
+        for (int cz = -renderDistance; cz <= renderDistance; cz++) {
+            Chunk* chunk = new Chunk();
+            chunk->initData(cx, cz);
+            registry.insert(cx, cz, chunk);
+            chunks.push_back(chunk);
+        }
+    }
+
+    const MeshMode modes[] = {MESH_NAIVE, MESH_GREEDY};
+    const char* names[] = {"naive ", "greedy"};
+    for (int m = 0; m < 2; m++) {
+        Chunk::s_meshMode = modes[m];
+        size_t vertices = 0;
+        auto start = BenchClock::now();
+        for (Chunk* chunk : chunks) {
+            for (int sec = 0; sec < Chunk::SECTION_COUNT; sec++) {
+                chunk->buildMesh(sec);
+            }
+            vertices += chunk->vertexCount();
+        }
+        double ms = elapsedNs(start) / 1e6;
+        std::cout << "  " << names[m] << " " << chunks.size() << " chunks: "
+                  << vertices << " vertices, " << vertices * sizeof(uint32_t) / 1024
+                  << " KB, " << ms << " ms (" << ms * 1000.0 / chunks.size() << " us/chunk)\n";
+    }
+    Chunk::s_meshMode = MESH_GREEDY;
+
+    for (Chunk* chunk : chunks) {
+        delete chunk;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 多线程生成/网格流水线：不同线程数的耗时，以及与串行结果的一致性
+// ---------------------------------------------------------------------------
+
+// FNV-1a：对所有区块（按坐标顺序）的方块和顶点数据求校验和
+static uint64_t worldChecksum(const ChunkMap& chunks, int renderDistance) {
+    uint64_t hash = 1469598103934665603ULL;
+    auto mix = [&hash](const void* data, size_t bytes) {
+        const uint8_t* p = (const uint8_t*)data;
+        for (size_t i = 0; i < bytes; i++) {
+            hash = (hash ^ p[i]) * 1099511628211ULL;
+        }
+    };
+    for (int cx = -renderDistance; cx <= renderDistance; cx++) {
+        for (int cz = -renderDistance; cz <= renderDistance; cz++) {
+            const Chunk* chunk = chunks.find(cx, cz);
+            for (int sec = 0; sec < Chunk::SECTION_COUNT; sec++) {
+                const ChunkSection* section = chunk->getSection(sec);
+                if (section == nullptr) {
+                    continue;
+                }
+                uint16_t dense[BlockStorage::VOLUME];
+                section->blocks.copyTo(dense);
+                mix(&sec, sizeof(sec));
+                mix(dense, sizeof(dense));
+                mix(section->vertices.data(), section->vertices.size() * sizeof(uint32_t));
+            }
+        }
+    }
+    return hash;
+}
+
+static void benchPipelineRun(int workers, int renderDistance, uint64_t* checksum) {
+    ChunkMap chunks;
+    ChunkPipeline pipeline(workers);
+    auto registerChunk = [&](Chunk* chunk) {
+        chunks.insert(chunk->m_chunkX, chunk->m_chunkZ, chunk);
+    };
+    auto noUpload = [](Chunk*, int) {};
+
+    auto start = BenchClock::now();
+    for (int cx = -renderDistance; cx <= renderDistance; cx++) {
+        for (int cz = -renderDistance; cz <= renderDistance; cz++) {
+            pipeline.requestGenerate(new Chunk(), cx, cz);
+        }
+    }
+    pipeline.waitIdle();
+    pipeline.processCompleted(registerChunk, noUpload);
+    double genMs = elapsedNs(start) / 1e6;
+
+    start = BenchClock::now();
+    chunks.forEach([&](int cx, int cz, Chunk* chunk) {
+        for (int sec = 0; sec < Chunk::SECTION_COUNT; sec++) {
+            pipeline.requestMesh(chunk, sec);
+        }
+    });
+    pipeline.waitIdle();
+    pipeline.processCompleted(registerChunk, noUpload);
+    double meshMs = elapsedNs(start) / 1e6;
+
+    *checksum = worldChecksum(chunks, renderDistance);
+    std::cout << "    " << workers << " workers: gen " << genMs << " ms, mesh " << meshMs
+              << " ms, total " << genMs + meshMs << " ms, checksum " << std::hex << *checksum
+              << std::dec << "\n";
+
+    chunks.forEach([](int cx, int cz, Chunk* chunk) {
+        delete chunk;
+    });
+}
+
+static void benchPipeline() {
+    const int renderDistance = 16;   // 33x33 = 1089 个区块
+    std::cout << "  " << (2 * renderDistance + 1) * (2 * renderDistance + 1) << " chunks:\n";
+
+    uint64_t serialChecksum = 0;
+    benchPipelineRun(0, renderDistance, &serialChecksum);
+
+    std::vector<int> workerCounts = {1, 2, 4};
+    int cores = (int)std::thread::hardware_concurrency();
+    if (cores > 4) {
+        workerCounts.push_back(cores);
+    }
+    bool deterministic = true;
+    for (int workers : workerCounts) {
+        uint64_t checksum = 0;
+        benchPipelineRun(workers, renderDistance, &checksum);
+        deterministic = deterministic && (checksum == serialChecksum);
+    }
+    std::cout << "    parallel output " << (deterministic ? "matches" : "DIFFERS FROM") << " serial output\n";
+}
+
+// ---------------------------------------------------------------------------
+// 视锥剔除：与 main.cpp 相同的投影参数，统计不同朝向下被剔除的区块比例
+// ---------------------------------------------------------------------------
+
+static void benchFrustum() {
+    const int renderDistance = 8;
+    const glm::vec3 eye(0.0f, 66.0f + 1.62f, 0.0f);
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 500.0f);
+
+    long long drawn = 0, culled = 0;
+    const int SAMPLES = 3600;
+    auto start = BenchClock::now();
+    for (int i = 0; i < SAMPLES; i++) {
+        float yaw = glm::radians(i * 0.1f);
+        float pitch = glm::radians(-10.0f);
+        glm::vec3 front(cos(yaw) * cos(pitch), sin(pitch), sin(yaw) * cos(pitch));
+        glm::mat4 view = glm::lookAt(eye, eye + front, glm::vec3(0.0f, 1.0f, 0.0f));
+        Frustum frustum(projection * view);
+        for (int cx = -renderDistance; cx <= renderDistance; cx++) {
+            for (int cz = -renderDistance; cz <= renderDistance; cz++) {
+                glm::vec3 boxMin(cx * 16.0f, 0.0f, cz * 16.0f);
+                glm::vec3 boxMax = boxMin + glm::vec3(16.0f, (float)Chunk::WORLD_HEIGHT, 16.0f);
+                if (frustum.intersectsAABB(boxMin, boxMax)) {
+                    drawn++;
+                } else {
+                    culled++;
+                }
+            }
+        }
+    }
+    double ns = elapsedNs(start) / (drawn + culled);
+    std::cout << "  fov 45, pitch -10, 360 yaws: drawn " << drawn / SAMPLES << " culled "
+              << culled / SAMPLES << " per frame (" << 100.0 * culled / (drawn + culled)
+              << "% culled), " << ns << " ns/AABB test\n";
+}
+
+// ---------------------------------------------------------------------------
+// 调色板方块存储：RENDER_DISTANCE=32 世界的内存占用，以及 get/set 速度
+// ---------------------------------------------------------------------------
+
+static void benchBlockStorage() {
+    const int renderDistance = 32;   // 65x65 = 4225 个区块
+    std::vector<Chunk*> chunks;
+    for (int cx = -renderDistance; cx <= renderDistance; cx++) {
+        for (int cz = -renderDistance; cz <= renderDistance; cz++) {
+            Chunk* chunk = new Chunk();
+            chunk->initData(cx, cz);
+            chunks.push_back(chunk);
+        }
+    }
+
+    // 对比对象：整列 16x256x16 的稠密 uint8_t 数组
+    size_t paletteBytes = 0;
+    size_t sectionCount = 0;
+    int bitsHistogram[17] = {0};
+    const BlockStorage* sample = nullptr;
+    for (Chunk* chunk : chunks) {
+        for (int sec = 0; sec < Chunk::SECTION_COUNT; sec++) {
+            const ChunkSection* section = chunk->getSection(sec);
+            if (section == nullptr) {
+                continue;
+            }
+            sectionCount++;
+            paletteBytes += sizeof(ChunkSection) + section->blocks.memoryUsage();
+            bitsHistogram[section->blocks.bitsPerBlock()]++;
+            if (sample == nullptr && section->blocks.bitsPerBlock() > 0 && chunk == chunks[chunks.size() / 2]) {
+                sample = &section->blocks;
+            }
+        }
+    }
+    size_t denseBytes = chunks.size() * (size_t)BlockStorage::VOLUME * Chunk::SECTION_COUNT;
+    std::cout << "  " << chunks.size() << " chunks, " << sectionCount << "/" << chunks.size() * Chunk::SECTION_COUNT
+              << " sections allocated: dense uint8_t " << denseBytes / 1024 << " KB, sections "
+              << paletteBytes / 1024 << " KB (" << 100.0 * paletteBytes / denseBytes << "%)\n"
+              << "    bits per block:";
+    for (int bits : {0, 1, 2, 4, 8, 16}) {
+        std::cout << " " << bits << "b=" << bitsHistogram[bits];
+    }
+    std::cout << "\n";
+
+    // 随机读取：取中心区块的地表段，与稠密数组对比
+    std::vector<uint8_t> dense(BlockStorage::VOLUME);
+    for (int i = 0; i < BlockStorage::VOLUME; i++) {
+        dense[i] = (uint8_t)sample->getIndex(i);
+    }
+    const int READS = 20000000;
+    std::vector<int> indices(4096);
+    std::mt19937 rng(7);
+    for (int& index : indices) {
+        index = (int)(rng() % BlockStorage::VOLUME);
+    }
+
+    auto start = BenchClock::now();
+    uintptr_t acc = 0;
+    for (int i = 0; i < READS; i++) {
+        acc += dense[indices[i & 4095]];
+    }
+    double denseNs = elapsedNs(start) / READS;
+
+    start = BenchClock::now();
+    for (int i = 0; i < READS; i++) {
+        acc += sample->getIndex(indices[i & 4095]);
+    }
+    double paletteNs = elapsedNs(start) / READS;
+    g_sink += acc;
+
+    BlockStorage storage;
+    start = BenchClock::now();
+    const int WRITES = 4000000;
+    for (int i = 0; i < WRITES; i++) {
+        storage.setIndex(indices[i & 4095], (uint16_t)(i & 3));
+    }
+    double setNs = elapsedNs(start) / WRITES;
+
+    std::cout << "    get: dense " << denseNs << " ns, palette " << paletteNs
+              << " ns (" << sample->bitsPerBlock() << " bits); set " << setNs << " ns\n";
+
+    for (Chunk* chunk : chunks) {
+        delete chunk;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 地形噪声：stb 逐点 fBm 与批量 SIMD fBm 的吞吐量（列/秒）和误差
+// ---------------------------------------------------------------------------
+
+static void benchNoise() {
+    const int renderDistance = 16;   // 33x33 个区块的全部地表列
+    const float scale = 0.05f;
+    const int width = (2 * renderDistance + 1) * Chunk::CHUNK_SIZE;
+    const int columns = width * width;
+    std::vector<float> xs(columns), ys(columns, 0.0f), zs(columns);
+    for (int i = 0; i < columns; i++) {
+        xs[i] = (float)(i / width - renderDistance * Chunk::CHUNK_SIZE) * scale;
+        zs[i] = (float)(i % width - renderDistance * Chunk::CHUNK_SIZE) * scale;
+    }
+
+    std::vector<float> reference(columns);
+    auto start = BenchClock::now();
+    for (int i = 0; i < columns; i++) {
+        reference[i] = stb_perlin_fbm_noise3(xs[i], ys[i], zs[i], 2.0f, 0.5f, 4);
+    }
+    double stbNs = (double)elapsedNs(start);
+    std::cout << "  " << columns << " columns, 4 octaves\n"
+              << "    stb_perlin_fbm_noise3 " << columns / (stbNs / 1e9) / 1e6 << " M columns/s\n";
+
+    std::vector<float> out(columns);
+    for (NoiseBackend backend : {NOISE_SCALAR, NOISE_SSE2, NOISE_AVX2}) {
+        if (!perlinBackendSupported(backend)) {
+            std::cout << "    batch " << perlinBackendName(backend) << ": not supported on this CPU\n";
+            continue;
+        }
+        // 与 initData 相同：每次 256 列（一个区块）
+        start = BenchClock::now();
+        for (int i = 0; i < columns; i += 256) {
+            perlinFbmNoise3Batch(&xs[i], &ys[i], &zs[i], &out[i], 256, 2.0f, 0.5f, 4, backend);
+        }
+        double ns = (double)elapsedNs(start);
+
+        float maxError = 0.0f;
+        for (int i = 0; i < columns; i++) {
+            maxError = std::max(maxError, std::fabs(out[i] - reference[i]));
+        }
+        std::cout << "    batch " << perlinBackendName(backend) << " " << columns / (ns / 1e9) / 1e6
+                  << " M columns/s (" << stbNs / ns << "x), max |error| " << maxError << "\n";
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 流式加载：以冲刺速度沿 +x 方向移动，按 60 FPS 节奏调用 streamer.update，统计每帧耗时
+// （没有 OpenGL 上下文，不含 GPU 上传）
+// ---------------------------------------------------------------------------
+
+static void benchStreaming() {
+    const int loadRadius = 8;
+    const float sprintSpeed = 12.9f;   // 与 main.cpp 的冲刺速度一致（方块/秒）
+    const double frameSeconds = 1.0 / 60.0;
+    const int FRAMES = 600;
+
+    ChunkMap chunks;
+    ChunkPipeline pipeline(ThreadPool::defaultThreadCount());
+    ChunkStreamer streamer(chunks, pipeline, nullptr, loadRadius, loadRadius + 2);
+
+    auto start = BenchClock::now();
+    streamer.setBudget(-1.0);
+    do {
+        streamer.update(0, 0);
+        pipeline.waitIdle();
+    } while (!streamer.isSettled());
+    streamer.update(0, 0);
+    std::cout << "  initial load: " << chunks.size() << " chunks in " << elapsedNs(start) / 1e6 << " ms\n";
+
+    streamer.setBudget(0.004);
+    std::vector<double> frameMs;
+    float playerX = 0.0f;
+    int maxBacklog = 0;
+    auto nextFrame = BenchClock::now();
+    for (int frame = 0; frame < FRAMES; frame++) {
+        playerX += sprintSpeed * (float)frameSeconds;
+        auto frameStart = BenchClock::now();
+        streamer.update(ChunkStreamer::toChunkCoord(playerX), 0);
+        frameMs.push_back(elapsedNs(frameStart) / 1e6);
+        maxBacklog = std::max(maxBacklog, streamer.generatingCount());
+
+        nextFrame += std::chrono::duration_cast<BenchClock::duration>(std::chrono::duration<double>(frameSeconds));
+        std::this_thread::sleep_until(nextFrame);
+    }
+
+    std::sort(frameMs.begin(), frameMs.end());
+    double sum = 0.0;
+    for (double ms : frameMs) {
+        sum += ms;
+    }
+    std::cout << "  sprint " << sprintSpeed * FRAMES * frameSeconds << " blocks over " << FRAMES
+              << " frames (budget 4 ms): update mean " << sum / FRAMES << " ms, p99 "
+              << frameMs[FRAMES * 99 / 100] << " ms, max " << frameMs.back() << " ms\n"
+              << "    loaded " << chunks.size() << " chunks, unloaded " << streamer.unloadedTotal()
+              << ", max generating in flight " << maxBacklog << "\n";
+
+    // 停下后追上进度（全部加载并完成网格）还需要的帧数
+    int catchUpFrames = 0;
+    while (!streamer.isSettled() && catchUpFrames < 600) {
+        std::this_thread::sleep_for(std::chrono::duration<double>(frameSeconds));
+        streamer.update(ChunkStreamer::toChunkCoord(playerX), 0);
+        catchUpFrames++;
+    }
+    std::cout << "    settled " << catchUpFrames << " frames after stopping\n";
+}
+
+// ---------------------------------------------------------------------------
+// 玩家碰撞：扫掠 AABB 与原先逐轴整步判定（floor/ceil 扫描整个包围盒）对比
+// ---------------------------------------------------------------------------
+
+// 原先的 Player::update：逐轴移动整步，碰撞则整步作废
+static void legacyPlayerUpdate(Player& player, float deltaTime, ChunkMap& chunks) {
+    player.velocity.y += Player::GRAVITY * deltaTime;
+    if (player.velocity.y < Player::TERMINAL_VELOCITY) {
+        player.velocity.y = Player::TERMINAL_VELOCITY;
+    }
+    for (int axis : {0, 1, 2}) {
+        glm::vec3 newPos = player.position;
+        newPos[axis] += player.velocity[axis] * deltaTime;
+        if (!player.checkCollision(newPos, chunks)) {
+            player.position[axis] = newPos[axis];
+            if (axis == 1) {
+                player.onGround = false;
+            }
+        } else {
+            if (axis == 1 && player.velocity.y < 0) {
+                player.onGround = true;
+            }
+            player.velocity[axis] = 0;
+        }
+    }
+}
+
+// 地表高度：该列最高实心方块的上表面
+static int surfaceHeight(ChunkMap& chunks, int x, int z) {
+    Player probe(glm::vec3(0.0f));
+    for (int y = Chunk::WORLD_HEIGHT - 1; y >= 0; y--) {
+        if (probe.isBlockSolid(x, y, z, chunks)) {
+            return y + 1;
+        }
+    }
+    return 0;
+}
+
+// 固定输入的一段行走：转圈走、定期跳、偶尔掉帧；返回末状态
+// penetrated 不为空时每帧检查包围盒是否与方块重叠（不计时）；为空时只计时
+template <typename Update>
+static glm::vec3 scriptedWalk(ChunkMap& chunks, Update update, int frames, size_t* lookups, double* ns,
+                              bool* penetrated) {
+    Player player(glm::vec3(0.5f, (float)surfaceHeight(chunks, 0, 0) + 0.01f, 0.5f));
+    if (penetrated != nullptr) {
+        *penetrated = false;
+    }
+    auto start = BenchClock::now();
+    for (int frame = 0; frame < frames; frame++) {
+        float angle = frame * 0.01f;
+        player.move(glm::vec3(std::cos(angle), 0.0f, std::sin(angle)), 12.9f);
+        if (frame % 40 == 0) {
+            player.jump();
+        }
+        float deltaTime = (frame % 97 == 0) ? 0.25f : 1.0f / 60.0f;   // 偶尔掉帧
+        update(player, deltaTime, chunks);
+        if (penetrated == nullptr) {
+            continue;
+        }
+
+        // 包围盒（向内收缩容差）覆盖的方块都必须是空气
+        size_t before = player.blockLookups;
+        AABB box = player.getAABB();
+        glm::vec3 inner0 = box.min + glm::vec3(Player::CONTACT_EPSILON);
+        glm::vec3 inner1 = box.max - glm::vec3(Player::CONTACT_EPSILON);
+        for (int x = (int)std::floor(inner0.x); x < (int)std::ceil(inner1.x); x++) {
+            for (int y = (int)std::floor(inner0.y); y < (int)std::ceil(inner1.y); y++) {
+                for (int z = (int)std::floor(inner0.z); z < (int)std::ceil(inner1.z); z++) {
+                    if (player.isBlockSolid(x, y, z, chunks)) {
+                        *penetrated = true;
+                    }
+                }
+            }
+        }
+        player.blockLookups = before;
+    }
+    *ns = (double)elapsedNs(start) / frames;
+    *lookups = player.blockLookups;
+    return player.position;
+}
+
+static void benchCollision() {
+    const int renderDistance = 4;
+    ChunkMap chunks;
+    for (int cx = -renderDistance; cx <= renderDistance; cx++) {
+        for (int cz = -renderDistance; cz <= renderDistance; cz++) {
+            Chunk* chunk = new Chunk();
+            chunk->initData(cx, cz);
+            chunks.insert(cx, cz, chunk);
+        }
+    }
+
+    // 1. 掉帧下落：终端速度、每帧 0.5 秒（一步 25 格），下方 y=140 有一层 1 格厚的平台
+    for (int x = -4; x < 4; x++) {
+        for (int z = -4; z < 4; z++) {
+            chunks.find(x < 0 ? -1 : 0, z < 0 ? -1 : 0)->setBlock(x & 15, 140, z & 15, BLOCK_STONE);
+        }
+    }
+    const char* names[] = {"legacy", "swept "};
+    for (int method = 0; method < 2; method++) {
+        Player player(glm::vec3(0.5f, 200.3f, 0.5f));
+        player.velocity.y = Player::TERMINAL_VELOCITY;
+        for (int frame = 0; frame < 20; frame++) {
+            if (method == 0) {
+                legacyPlayerUpdate(player, 0.5f, chunks);
+            } else {
+                player.update(0.5f, chunks);
+            }
+        }
+        std::cout << "  " << names[method] << " drop from 200.3 at terminal velocity, dt 0.5 s onto platform top 141: feet at "
+                  << player.position.y << (player.onGround ? ", on ground" : ", NOT on ground") << "\n";
+    }
+    for (int x = -4; x < 4; x++) {
+        for (int z = -4; z < 4; z++) {
+            chunks.find(x < 0 ? -1 : 0, z < 0 ? -1 : 0)->setBlock(x & 15, 140, z & 15, BLOCK_AIR);
+        }
+    }
+
+    // 2. 固定脚本行走：每帧查询方块数、耗时，两次运行结果是否逐位一致，是否进入方块
+    const int FRAMES = 20000;
+    auto sweptUpdate = [](Player& player, float deltaTime, ChunkMap& chunks) {
+        player.update(deltaTime, chunks);
+    };
+    size_t legacyLookups = 0, sweptLookups = 0, checkLookups = 0;
+    double legacyNs = 0.0, sweptNs = 0.0, checkNs = 0.0;
+    bool legacyPenetrated = false, sweptPenetrated = false;
+    scriptedWalk(chunks, legacyPlayerUpdate, FRAMES, &legacyLookups, &legacyNs, nullptr);
+    scriptedWalk(chunks, legacyPlayerUpdate, FRAMES, &checkLookups, &checkNs, &legacyPenetrated);
+    glm::vec3 first = scriptedWalk(chunks, sweptUpdate, FRAMES, &sweptLookups, &sweptNs, nullptr);
+    glm::vec3 second = scriptedWalk(chunks, sweptUpdate, FRAMES, &checkLookups, &checkNs, &sweptPenetrated);
+
+    std::cout << "  scripted walk, " << FRAMES << " frames:\n"
+              << "    legacy " << (double)legacyLookups / FRAMES << " block lookups/update, " << legacyNs
+              << " ns/update, penetrated blocks: " << (legacyPenetrated ? "YES" : "no") << "\n"
+              << "    swept  " << (double)sweptLookups / FRAMES << " block lookups/update, " << sweptNs
+              << " ns/update, penetrated blocks: " << (sweptPenetrated ? "YES" : "no") << "\n"
+              << "    swept deterministic: " << ((first == second && sweptLookups == checkLookups) ? "yes" : "NO") << "\n";
+
+    chunks.forEach([](int cx, int cz, Chunk* chunk) {
+        delete chunk;
+    });
+}
+
+// ---------------------------------------------------------------------------
+// 体素射线检测：缓存区块指针的 DDA 与逐格查 ChunkMap 的 DDA 对比（射线/秒）
+// ---------------------------------------------------------------------------
+
+// 对照组：同样的网格遍历，但每一格都重新计算区块坐标并查 ChunkMap
+static RaycastHit raycastPerVoxelLookup(const ChunkMap& chunks, const glm::vec3& origin, const glm::vec3& direction,
+                                        float maxDistance) {
+    RaycastHit result;
+    const glm::vec3 dir = glm::normalize(direction);
+    const float INF = 1e30f;
+    glm::ivec3 cell((int)std::floor(origin.x), (int)std::floor(origin.y), (int)std::floor(origin.z));
+    glm::ivec3 step(0);
+    glm::vec3 tMax(INF), tDelta(INF);
+    for (int i = 0; i < 3; i++) {
+        if (dir[i] > 0.0f) {
+            step[i] = 1;
+            tDelta[i] = 1.0f / dir[i];
+            tMax[i] = ((float)cell[i] + 1.0f - origin[i]) * tDelta[i];
+        } else if (dir[i] < 0.0f) {
+            step[i] = -1;
+            tDelta[i] = -1.0f / dir[i];
+            tMax[i] = (origin[i] - (float)cell[i]) * tDelta[i];
+        }
+    }
+    float t = 0.0f;
+    glm::ivec3 normal(0);
+    while (true) {
+        int chunkX = (cell.x >= 0) ? cell.x / 16 : (cell.x - 15) / 16;
+        int chunkZ = (cell.z >= 0) ? cell.z / 16 : (cell.z - 15) / 16;
+        const Chunk* chunk = chunks.find(chunkX, chunkZ);
+        if (chunk != nullptr && cell.y >= 0 && cell.y < Chunk::WORLD_HEIGHT) {
+            uint16_t blockType = chunk->getBlock(cell.x - chunkX * 16, cell.y, cell.z - chunkZ * 16);
+            if (blockType != BLOCK_AIR) {
+                result.hit = true;
+                result.block = cell;
+                result.normal = normal;
+                result.distance = t;
+                result.blockType = blockType;
+                return result;
+            }
+        }
+        int axis = (tMax.x < tMax.y) ? ((tMax.x < tMax.z) ? 0 : 2) : ((tMax.y < tMax.z) ? 1 : 2);
+        t = tMax[axis];
+        if (t > maxDistance) {
+            return result;
+        }
+        cell[axis] += step[axis];
+        tMax[axis] += tDelta[axis];
+        normal = glm::ivec3(0);
+        normal[axis] = -step[axis];
+        if ((cell.y < 0 && step.y < 0) || (cell.y >= Chunk::WORLD_HEIGHT && step.y > 0)) {
+            return result;
+        }
+    }
+}
+
+static void benchRaycast() {
+    const int renderDistance = 8;
+    ChunkMap chunks;
+    for (int cx = -renderDistance; cx <= renderDistance; cx++) {
+        for (int cz = -renderDistance; cz <= renderDistance; cz++) {
+            Chunk* chunk = new Chunk();
+            chunk->initData(cx, cz);
+            chunks.insert(cx, cz, chunk);
+        }
+    }
+
+    // 两种场景：玩家视线（短距离、略向下，大多命中地面）和 AI 视线（长距离、近乎水平）
+    struct Scenario {
+        const char* name;
+        float maxDistance;
+        float minPitch, maxPitch;
+    };
+    const Scenario scenarios[] = {
+        {"block picking, reach 8  ", 8.0f, -1.2f, 0.3f},
+        {"line of sight, range 64 ", 64.0f, -0.15f, 0.15f},
+    };
+    const int RAYS = 200000;
+    for (const Scenario& scenario : scenarios) {
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<float> coord(-100.0f, 100.0f);
+        std::uniform_real_distribution<float> yaw(0.0f, 6.2831853f);
+        std::uniform_real_distribution<float> pitch(scenario.minPitch, scenario.maxPitch);
+        std::vector<glm::vec3> origins(RAYS), directions(RAYS);
+        for (int i = 0; i < RAYS; i++) {
+            float x = coord(rng), z = coord(rng);
+            origins[i] = glm::vec3(x, 67.62f + (float)(i % 5), z);
+            float a = yaw(rng), b = pitch(rng);
+            directions[i] = glm::vec3(std::cos(a) * std::cos(b), std::sin(b), std::sin(a) * std::cos(b));
+        }
+
+        int cachedHits = 0, lookupHits = 0, mismatches = 0;
+        std::vector<RaycastHit> hits(RAYS);
+        auto start = BenchClock::now();
+        for (int i = 0; i < RAYS; i++) {
+            hits[i] = raycastBlocks(chunks, origins[i], directions[i], scenario.maxDistance);
+            cachedHits += hits[i].hit;
+        }
+        double cachedNs = (double)elapsedNs(start);
+
+        start = BenchClock::now();
+        for (int i = 0; i < RAYS; i++) {
+            RaycastHit hit = raycastPerVoxelLookup(chunks, origins[i], directions[i], scenario.maxDistance);
+            lookupHits += hit.hit;
+            if (hit.hit != hits[i].hit || hit.block != hits[i].block || hit.normal != hits[i].normal) {
+                mismatches++;
+            }
+        }
+        double lookupNs = (double)elapsedNs(start);
+
+        std::cout << "  " << scenario.name << ": cached chunk pointer " << RAYS / (cachedNs / 1e9) / 1e6
+                  << " M rays/s, per-voxel ChunkMap lookup " << RAYS / (lookupNs / 1e9) / 1e6 << " M rays/s ("
+                  << lookupNs / cachedNs << "x), hit " << 100.0 * cachedHits / RAYS << "%, mismatches "
+                  << mismatches << "\n";
+    }
+
+    chunks.forEach([](int cx, int cz, Chunk* chunk) {
+        delete chunk;
+    });
+}
+
+// ---------------------------------------------------------------------------
+// 方块编辑：每帧 K 次随机破坏/放置，统计主线程每帧耗时和编辑到网格更新完成的帧数
+// ---------------------------------------------------------------------------
+
+static void benchEdits() {
+    ChunkMap chunks;
+    ChunkPipeline pipeline(ThreadPool::defaultThreadCount());
+    ChunkStreamer streamer(chunks, pipeline, nullptr, 8, 10);
+    streamer.setBudget(-1.0);
+    do {
+        streamer.update(0, 0);
+        pipeline.waitIdle();
+    } while (!streamer.isSettled());
+    streamer.update(0, 0);
+    streamer.setBudget(0.004);
+
+    // 单个地表段重建网格的耗时（快照 + 贪婪网格）
+    {
+        Chunk* chunk = chunks.find(0, 0);
+        int section = 64 / Chunk::CHUNK_SIZE;
+        const int REPEAT = 200;
+        auto start = BenchClock::now();
+        for (int i = 0; i < REPEAT; i++) {
+            chunk->buildMesh(section);
+        }
+        std::cout << "  remesh one surface section: " << elapsedNs(start) / 1e3 / REPEAT << " us\n";
+    }
+
+    const double frameSeconds = 1.0 / 60.0;
+    const int FRAMES = 120;
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> coord(-80, 79);
+    for (int editsPerFrame : {1, 10, 100}) {
+        struct PendingEdit {
+            Chunk* chunk;
+            int section;
+            int frame;
+        };
+        std::vector<PendingEdit> pending;
+        std::vector<double> frameMs;
+        std::vector<int> latencies;
+        auto nextFrame = BenchClock::now();
+        for (int frame = 0; frame < FRAMES + 30; frame++) {
+            // 编辑位置在计时之外算好：地表方块破坏，或在地表上放置
+            std::vector<glm::ivec4> edits;
+            if (frame < FRAMES) {
+                for (int k = 0; k < editsPerFrame; k++) {
+                    int x = coord(rng), z = coord(rng);
+                    int y = Chunk::WORLD_HEIGHT - 1;
+                    while (y > 0 && chunks.getBlock(x, y, z) == BLOCK_AIR) {
+                        y--;
+                    }
+                    bool place = (rng() & 1) != 0;
+                    edits.push_back(glm::ivec4(x, place ? y + 1 : y, z, place ? BLOCK_DIRT : BLOCK_AIR));
+                }
+            }
+
+            auto start = BenchClock::now();
+            for (const glm::ivec4& edit : edits) {
+                if (streamer.setBlock(edit.x, edit.y, edit.z, (uint16_t)edit.w)) {
+                    Chunk* chunk = chunks.find(ChunkMap::blockToChunk(edit.x), ChunkMap::blockToChunk(edit.z));
+                    pending.push_back({chunk, edit.y / Chunk::CHUNK_SIZE, frame});
+                }
+            }
+            streamer.update(0, 0);
+            if (frame < FRAMES) {
+                frameMs.push_back(elapsedNs(start) / 1e6);
+            }
+
+            // 编辑所在的段没有待重建标记、所在区块也没有进行中的网格任务，即已更新完成
+            for (size_t i = 0; i < pending.size(); ) {
+                ChunkSection* section = pending[i].chunk->getSection(pending[i].section);
+                if (!section->meshDirty && pending[i].chunk->m_pendingMeshJobs == 0) {
+                    latencies.push_back(frame - pending[i].frame);
+                    pending[i] = pending.back();
+                    pending.pop_back();
+                } else {
+                    i++;
+                }
+            }
+
+            nextFrame += std::chrono::duration_cast<BenchClock::duration>(std::chrono::duration<double>(frameSeconds));
+            std::this_thread::sleep_until(nextFrame);
+        }
+
+        std::sort(frameMs.begin(), frameMs.end());
+        std::sort(latencies.begin(), latencies.end());
+        double sum = 0.0;
+        for (double ms : frameMs) {
+            sum += ms;
+        }
+        std::cout << "  " << editsPerFrame << " edits/frame: main thread mean " << sum / frameMs.size()
+                  << " ms, max " << frameMs.back() << " ms; visible after median "
+                  << latencies[latencies.size() / 2] << " frames, p99 " << latencies[latencies.size() * 99 / 100]
+                  << ", max " << latencies.back() << " frames" << (pending.empty() ? "" : " (some never finished)")
+                  << "\n";
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 区域文件存档：一个区域（32x32 区块）的保存/读取耗时与生成地形对比，以及只写回修改过的区块
+// ---------------------------------------------------------------------------
+
+static bool sameBlocks(const Chunk& a, const Chunk& b) {
+    for (int s = 0; s < Chunk::SECTION_COUNT; s++) {
+        const ChunkSection* sa = a.getSection(s);
+        const ChunkSection* sb = b.getSection(s);
+        if ((sa == nullptr) != (sb == nullptr)) {
+            return false;
+        }
+        if (sa == nullptr) {
+            continue;
+        }
+        for (int i = 0; i < BlockStorage::VOLUME; i++) {
+            if (sa->blocks.getIndex(i) != sb->blocks.getIndex(i)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// 随机挑 16 个区块，每个在地表附近放置 64 个泥土（绕过 ChunkMap，手动设置存档标记）
+static void editSomeChunks(std::vector<std::unique_ptr<Chunk>>& chunks) {
+    std::mt19937 rng(3);
+    for (int k = 0; k < 16; k++) {
+        Chunk& chunk = *chunks[rng() % chunks.size()];
+        for (int e = 0; e < 64; e++) {
+            chunk.setBlock((int)(rng() % 16), 60 + (int)(rng() % 20), (int)(rng() % 16), BLOCK_DIRT);
+        }
+        chunk.m_needsSave = true;
+        chunk.m_hasEdits = true;
+    }
+}
+
+static void benchRegion() {
+    const int R = RegionFile::REGION_SIZE;
+    std::string directory = (std::filesystem::temp_directory_path() / "mymc_bench_region").string();
+    std::filesystem::remove_all(directory);
+
+    std::vector<std::unique_ptr<Chunk>> generated;
+    auto start = BenchClock::now();
+    for (int cz = 0; cz < R; cz++) {
+        for (int cx = 0; cx < R; cx++) {
+            generated.emplace_back(new Chunk());
+            generated.back()->initData(cx, cz);
+        }
+    }
+    double generateUs = elapsedNs(start) / 1e3 / generated.size();
+
+    size_t rawBytes = 0;
+    for (const auto& chunk : generated) {
+        for (int s = 0; s < Chunk::SECTION_COUNT; s++) {
+            const ChunkSection* section = chunk->getSection(s);
+            if (section != nullptr) {
+                rawBytes += section->blocks.words().size() * sizeof(uint64_t) + section->blocks.paletteSize() * 2;
+            }
+        }
+    }
+
+    size_t savedBytes = 0;
+    {
+        WorldStorage storage(directory);
+        start = BenchClock::now();
+        for (const auto& chunk : generated) {
+            storage.saveChunk(*chunk);
+        }
+        double saveUs = elapsedNs(start) / 1e3 / generated.size();
+        savedBytes = storage.bytesWritten();
+        std::cout << "  " << generated.size() << " chunks: generate " << generateUs << " us/chunk, save "
+                  << saveUs << " us/chunk\n"
+                  << "    palette data " << rawBytes / 1024 << " KB -> encoded " << savedBytes / 1024 << " KB ("
+                  << savedBytes / generated.size() << " B/chunk)\n";
+    }
+    std::string regionPath = directory + "/r.0.0.region";
+    std::cout << "    region file " << std::filesystem::file_size(regionPath) / 1024 << " KB\n";
+
+    // 重新打开（偏移表从文件读取），逐个读取并与生成的地形对比
+    {
+        WorldStorage storage(directory);
+        std::vector<std::unique_ptr<Chunk>> loaded;
+        start = BenchClock::now();
+        for (int cz = 0; cz < R; cz++) {
+            for (int cx = 0; cx < R; cx++) {
+                loaded.emplace_back(new Chunk());
+                if (!storage.loadChunk(*loaded.back(), cx, cz)) {
+                    std::cout << "    load failed at " << cx << "," << cz << "\n";
+                    return;
+                }
+            }
+        }
+        double loadUs = elapsedNs(start) / 1e3 / loaded.size();
+        size_t mismatches = 0;
+        for (size_t i = 0; i < loaded.size(); i++) {
+            mismatches += sameBlocks(*loaded[i], *generated[i]) ? 0 : 1;
+        }
+        std::cout << "    load " << loadUs << " us/chunk (" << generateUs / loadUs << "x faster than generating), "
+                  << mismatches << " mismatches\n";
+
+        // 编辑少量区块后整体保存：只有 m_needsSave 的区块写盘
+        editSomeChunks(loaded);
+        size_t written = 0;
+        start = BenchClock::now();
+        for (const auto& chunk : loaded) {
+            if (chunk->m_needsSave) {
+                storage.saveChunk(*chunk);
+                written++;
+            }
+        }
+        std::cout << "    resave after editing: " << written << "/" << loaded.size() << " chunks written, "
+                  << storage.bytesWritten() / 1024 << " KB in " << elapsedNs(start) / 1e6 << " ms; region file "
+                  << std::filesystem::file_size(regionPath) / 1024 << " KB\n";
+    }
+    std::filesystem::remove_all(directory);
+
+    // 增量存档：同样的编辑，所有区块都交给 saveChunk（没编辑过的区块不写盘），与完整存档的字节数对比
+    editSomeChunks(generated);
+    size_t fullBytes = 0;
+    size_t editedChunks = 0;
+    std::vector<uint8_t> encoded;
+    for (const auto& chunk : generated) {
+        WorldStorage::encodeChunk(*chunk, encoded);
+        fullBytes += encoded.size();
+        editedChunks += chunk->m_hasEdits ? 1 : 0;
+    }
+    {
+        WorldStorage storage(directory, SAVE_DELTA);
+        start = BenchClock::now();
+        for (const auto& chunk : generated) {
+            storage.saveChunk(*chunk);
+        }
+        double saveMs = elapsedNs(start) / 1e6;
+        size_t deltaBytes = storage.bytesWritten();
+        std::cout << "  delta save, " << editedChunks << " edited chunks: " << storage.chunksSaved() << "/"
+                  << generated.size() << " chunks written, " << deltaBytes << " B in " << saveMs << " ms ("
+                  << (double)deltaBytes / generated.size() << " B/chunk vs full dump "
+                  << fullBytes / generated.size() << " B/chunk, " << (double)fullBytes / deltaBytes << "x smaller)\n"
+                  << "    per edited chunk: delta " << deltaBytes / std::max<size_t>(editedChunks, 1)
+                  << " B, full " << fullBytes / generated.size() << " B; region file "
+                  << std::filesystem::file_size(regionPath) / 1024 << " KB\n";
+    }
+    {
+        // 重新打开后读取：有存档的区块重新生成并应用修改，其余的按流水线的做法直接生成
+        WorldStorage storage(directory, SAVE_DELTA);
+        size_t mismatches = 0;
+        start = BenchClock::now();
+        for (int cz = 0; cz < R; cz++) {
+            for (int cx = 0; cx < R; cx++) {
+                Chunk chunk;
+                if (!storage.loadChunk(chunk, cx, cz)) {
+                    chunk.initData(cx, cz);
+                }
+                mismatches += sameBlocks(chunk, *generated[cz * R + cx]) ? 0 : 1;
+            }
+        }
+        std::cout << "    delta load + verify " << elapsedNs(start) / 1e3 / generated.size() << " us/chunk ("
+                  << storage.chunksLoaded() << " from disk), " << mismatches << " mismatches\n";
+    }
+    std::filesystem::remove_all(directory);
+}
+
+// ---------------------------------------------------------------------------
+// 存档 I/O 线程：完整存档下来回冲刺（去程卸载的区块写盘，回程从存档读取），统计主线程每帧耗时和 I/O 延迟
+// ---------------------------------------------------------------------------
+
+static void printIOStats(const ChunkIO::Stats& stats) {
+    std::cout << "    io: " << stats.loads << " loads p50 " << stats.loadP50 << " / p99 " << stats.loadP99
+              << " / max " << stats.loadMax << " ms; " << stats.saves << " saves p50 " << stats.saveP50
+              << " / p99 " << stats.saveP99 << " / max " << stats.saveMax << " ms; " << stats.coalescedSaves
+              << " coalesced, " << stats.syncs << " fsyncs in " << stats.batches << " batches, max queue depth "
+              << stats.maxQueueDepth << "\n";
+}
+
+static void benchIO() {
+    std::string directory = (std::filesystem::temp_directory_path() / "mymc_bench_io").string();
+    std::filesystem::remove_all(directory);
+
+    // 主线程上每个卸载区块的开销：同步保存（编码 + 写入 + fflush）与提交给 I/O 线程（复制快照）
+    {
+        WorldStorage storage(directory, SAVE_FULL);
+        const int COUNT = 256;
+        std::vector<std::unique_ptr<Chunk>> chunks;
+        for (int i = 0; i < COUNT; i++) {
+            chunks.emplace_back(new Chunk());
+            chunks.back()->initData(i % 16, i / 16);
+        }
+        auto start = BenchClock::now();
+        for (const auto& chunk : chunks) {
+            storage.saveChunk(*chunk);
+        }
+        double syncUs = elapsedNs(start) / 1e3 / COUNT;
+        ChunkIO io(storage);
+        start = BenchClock::now();
+        for (const auto& chunk : chunks) {
+            io.requestSave(*chunk);
+        }
+        double asyncUs = elapsedNs(start) / 1e3 / COUNT;
+        io.waitIdle();
+        std::cout << "  main thread per saved chunk: synchronous " << syncUs << " us, queued to I/O thread "
+                  << asyncUs << " us\n";
+    }
+    std::filesystem::remove_all(directory);
+
+    WorldStorage storage(directory, SAVE_FULL);
+    ChunkIO io(storage);
+    ChunkMap chunks;
+    ChunkPipeline pipeline(ThreadPool::defaultThreadCount());
+    ChunkStreamer streamer(chunks, pipeline, nullptr, 8, 10);
+    streamer.setIO(&io);
+    streamer.setBudget(-1.0);
+    do {
+        streamer.update(0, 0);
+        pipeline.waitIdle();
+        io.waitIdle();
+    } while (!streamer.isSettled());
+    streamer.update(0, 0);
+    streamer.setBudget(0.004);
+
+    const float sprintSpeed = 12.9f;
+    const double frameSeconds = 1.0 / 60.0;
+    const int FRAMES = 600;
+    float playerX = 0.0f;
+    for (float direction : {1.0f, -1.0f}) {
+        std::vector<double> frameMs;
+        auto nextFrame = BenchClock::now();
+        for (int frame = 0; frame < FRAMES; frame++) {
+            playerX += direction * sprintSpeed * (float)frameSeconds;
+            auto frameStart = BenchClock::now();
+            streamer.update(ChunkStreamer::toChunkCoord(playerX), 0);
+            frameMs.push_back(elapsedNs(frameStart) / 1e6);
+            nextFrame += std::chrono::duration_cast<BenchClock::duration>(std::chrono::duration<double>(frameSeconds));
+            std::this_thread::sleep_until(nextFrame);
+        }
+        std::sort(frameMs.begin(), frameMs.end());
+        double sum = 0.0;
+        for (double ms : frameMs) {
+            sum += ms;
+        }
+        std::cout << "  sprint " << (direction > 0 ? "out (saving)" : "back (loading)") << ": update mean "
+                  << sum / FRAMES << " ms, p99 " << frameMs[FRAMES * 99 / 100] << " ms, max " << frameMs.back()
+                  << " ms\n";
+        printIOStats(io.stats());
+    }
+    streamer.shutdown();
+    std::cout << "  after shutdown: " << storage.chunksSaved() << " chunks saved, " << storage.chunksLoaded()
+              << " loaded from disk\n";
+    printIOStats(io.stats());
+    std::filesystem::remove_all(directory);
+}
+
+// ---------------------------------------------------------------------------
+// 区域文件读取：预先生成 2x2 个区域（4096 个区块）的完整存档，对比 fread 与 mmap 两种读取方式的吞吐量
+// （文件都在页缓存中；第一遍包含打开文件/建立映射，第二遍为热读取）
+// ---------------------------------------------------------------------------
+
+static double loadAll(WorldStorage& storage, int side, int threads, bool decode, size_t* failures) {
+    std::atomic<size_t> failed(0);
+    std::atomic<uintptr_t> checksum(0);
+    auto work = [&](int first, int step) {
+        Chunk chunk;
+        ChunkData data;
+        uintptr_t sum = 0;
+        for (int i = first; i < side * side; i += step) {
+            int cx = i % side, cz = i / side;
+            bool ok = decode ? storage.loadChunk(chunk, cx, cz) : storage.readChunkData(cx, cz, data);
+            failed += ok ? 0 : 1;
+            // 只读取时也要访问全部字节（mmap 只是拿到指针，不访问就不会读入页面）
+            for (size_t b = 0; !decode && ok && b < data.size(); b++) {
+                sum += data.data()[b];
+            }
+        }
+        checksum += sum;
+    };
+    auto start = BenchClock::now();
+    if (threads <= 1) {
+        work(0, 1);
+    } else {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back(work, t, threads);
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+    double seconds = elapsedNs(start) / 1e9;
+    g_sink += checksum;
+    *failures += failed;
+    return side * side / seconds;
+}
+
+static void benchMmap() {
+    const int side = 2 * RegionFile::REGION_SIZE;
+    std::string directory = (std::filesystem::temp_directory_path() / "mymc_bench_mmap").string();
+    std::filesystem::remove_all(directory);
+    {
+        WorldStorage storage(directory, SAVE_FULL);
+        Chunk chunk;
+        for (int cz = 0; cz < side; cz++) {
+            for (int cx = 0; cx < side; cx++) {
+                chunk.initData(cx, cz);
+                storage.saveChunk(chunk, false);
+            }
+        }
+        storage.syncAll();
+        std::cout << "  pre-generated " << side * side << " chunks, " << storage.bytesWritten() / 1024
+                  << " KB of chunk data\n";
+    }
+
+    // 抽查：两种方式读出的区块与生成的地形一致
+    size_t mismatches = 0;
+    for (ReadMode mode : {READ_BUFFERED, READ_MMAP}) {
+        WorldStorage storage(directory, SAVE_FULL, mode);
+        for (int i = 0; i < 64; i++) {
+            int cx = (i * 37) % side, cz = (i * 11) % side;
+            Chunk loaded, generated;
+            generated.initData(cx, cz);
+            mismatches += (storage.loadChunk(loaded, cx, cz) && sameBlocks(loaded, generated)) ? 0 : 1;
+        }
+    }
+    std::cout << "    spot check: " << mismatches << " mismatches\n";
+
+    std::vector<int> threadCounts = {1};
+    if (ThreadPool::defaultThreadCount() > 1) {
+        threadCounts.push_back(ThreadPool::defaultThreadCount());
+    }
+    size_t failures = 0;
+    for (bool decode : {false, true}) {
+        for (int threadCount : threadCounts) {
+            double rate[2];
+            for (ReadMode mode : {READ_BUFFERED, READ_MMAP}) {
+                WorldStorage storage(directory, SAVE_FULL, mode);
+                loadAll(storage, side, threadCount, decode, &failures);   // 打开文件 / 建立映射
+                rate[mode] = loadAll(storage, side, threadCount, decode, &failures);
+            }
+            std::cout << "  " << (decode ? "read + decode" : "read only") << ", " << threadCount << " thread"
+                      << (threadCount > 1 ? "s" : "") << ": fread " << rate[READ_BUFFERED] / 1e3
+                      << " K chunks/s, mmap " << rate[READ_MMAP] / 1e3 << " K chunks/s ("
+                      << rate[READ_MMAP] / rate[READ_BUFFERED] << "x)\n";
+        }
+    }
+    if (failures != 0) {
+        std::cout << "    " << failures << " loads failed\n";
+    }
+    std::filesystem::remove_all(directory);
+}
+
+// ---------------------------------------------------------------------------
+// 性能分析器开销：关闭 / 打开时每个 PROFILE_ZONE 的成本，以及记录整个流水线并导出 trace
+// ---------------------------------------------------------------------------
+
+static double zoneCostNs(int iterations) {
+    auto start = BenchClock::now();
+    for (int i = 0; i < iterations; i++) {
+        PROFILE_ZONE("bench zone");
+        g_sink += i;
+    }
+    return elapsedNs(start) / iterations;
+}
+
+// 同样的循环但没有计时段，作为扣除循环本身开销的基准
+static double loopCostNs(int iterations) {
+    auto start = BenchClock::now();
+    for (int i = 0; i < iterations; i++) {
+        g_sink += i;
+    }
+    return elapsedNs(start) / iterations;
+}
+
+static void benchProfiler() {
+    const int iterations = 1 << 22;
+    // 各取多次中的最小值，减少调度和频率变化的干扰
+    double loopNs = 1e30, disabledNs = 1e30, enabledNs = 1e30;
+    for (int repeat = 0; repeat < 5; repeat++) {
+        loopNs = std::min(loopNs, loopCostNs(iterations));
+        disabledNs = std::min(disabledNs, zoneCostNs(iterations));
+    }
+    Profiler::setEnabled(true);
+    for (int repeat = 0; repeat < 3; repeat++) {
+        enabledNs = std::min(enabledNs, zoneCostNs(iterations / 4));
+    }
+    Profiler::setEnabled(false);
+    std::cout << "  empty loop " << loopNs << " ns/iter, with zone: disabled " << disabledNs << " ns, enabled "
+              << enabledNs << " ns\n";
+    std::cout << "  per zone (loop subtracted): disabled " << std::max(0.0, disabledNs - loopNs) << " ns, enabled "
+              << enabledNs - loopNs << " ns\n";
+#ifdef NDEBUG
+    std::cout << "  optimized build\n";
+#else
+    std::cout << "  NOTE: unoptimized build (CMAKE_BUILD_TYPE not Release), per-zone costs are not representative\n";
+#endif
+
+    // 同一个流水线任务量，关闭和打开分析器各跑一次
+    const int renderDistance = 8;
+    uint64_t checksum[2] = {0, 0};
+    for (bool enabled : {false, true}) {
+        std::cout << "  profiler " << (enabled ? "on " : "off") << ":\n";
+        Profiler::setEnabled(enabled);
+        benchPipelineRun(ThreadPool::defaultThreadCount(), renderDistance, &checksum[enabled ? 1 : 0]);
+        Profiler::setEnabled(false);
+    }
+
+    std::string path = (std::filesystem::temp_directory_path() / "mymc_bench_trace.json").string();
+    auto start = BenchClock::now();
+    long events = Profiler::writeChromeTrace(path);
+    double writeMs = elapsedNs(start) / 1e6;
+    std::error_code error;
+    uintmax_t bytes = std::filesystem::file_size(path, error);
+    std::cout << "  trace: " << events << " zones, " << (error ? 0 : bytes) / 1024 << " KB written in "
+              << writeMs << " ms, output " << (checksum[0] == checksum[1] ? "unchanged" : "CHANGED")
+              << " by profiling\n";
+    std::filesystem::remove(path, error);
+}
+
+// ---------------------------------------------------------------------------
+// 可配置的世界：地形生成、网格的 CPU 部分、碰撞检测、区块查找，输出 min/median/p99
+// 地形只由区块坐标决定，种子选择世界中的一块区域（确定性的区块偏移），不同种子测到不同的地形
+// ---------------------------------------------------------------------------
+
+static void benchWorld() {
+    const int radius = g_options.worldRadius;
+    const int repeats = g_options.repeats;
+    std::mt19937 rng(g_options.seed);
+    std::uniform_int_distribution<int> offsetDist(-100000, 100000);
+    const int originX = (g_options.seed == 0) ? 0 : offsetDist(rng);
+    const int originZ = (g_options.seed == 0) ? 0 : offsetDist(rng);
+    const int side = 2 * radius + 1;
+    std::cout << "  radius " << radius << " (" << side * side << " chunks), seed " << g_options.seed
+              << " (origin chunk " << originX << "," << originZ << "), " << repeats << " repeats\n";
+
+    // 地形生成：每个区块单独计时（多生成一圈作为网格的相邻区块）
+    ChunkMap chunks;
+    std::vector<double> samples;
+    for (int repeat = 0; repeat < repeats; repeat++) {
+        for (int dx = -radius - 1; dx <= radius + 1; dx++) {
+            for (int dz = -radius - 1; dz <= radius + 1; dz++) {
+                int cx = originX + dx, cz = originZ + dz;
+                Chunk* chunk = (repeat == 0) ? new Chunk() : chunks.find(cx, cz);
+                auto start = BenchClock::now();
+                chunk->initData(cx, cz);
+                samples.push_back(elapsedNs(start));
+                if (repeat == 0) {
+                    chunks.insert(cx, cz, chunk);
+                }
+            }
+        }
+    }
+    reportSamples("world", "Chunk::initData per chunk", samples);
+
+    // 网格的 CPU 部分（gatherPadded + buildVertices）：每个非空的段单独计时
+    samples.clear();
+    size_t vertices = 0;
+    for (int repeat = 0; repeat < repeats; repeat++) {
+        for (int dx = -radius; dx <= radius; dx++) {
+            for (int dz = -radius; dz <= radius; dz++) {
+                Chunk* chunk = chunks.find(originX + dx, originZ + dz);
+                for (int s = 0; s < Chunk::SECTION_COUNT; s++) {
+                    if (chunk->getSection(s) == nullptr) {
+                        continue;
+                    }
+                    auto start = BenchClock::now();
+                    chunk->buildMesh(s);
+                    samples.push_back(elapsedNs(start));
+                    vertices += (repeat == 0) ? chunk->getSection(s)->vertices.size() : 0;
+                }
+            }
+        }
+    }
+    reportSamples("world", "mesh CPU per section", samples);
+    size_t vertexBytes = 0;
+    chunks.forEach([&](int cx, int cz, Chunk* chunk) {
+        vertexBytes += chunk->vertexBytes();
+    });
+    std::cout << "    " << vertices << " vertices (" << (Chunk::s_meshMode == MESH_GREEDY ? "greedy" : "naive")
+              << "), CPU copies " << vertexBytes / 1024 << " KB until uploaded\n";
+
+    // 碰撞检测：地表附近的随机位置（一部分嵌进地面），每个样本是一批调用的平均
+    const int batch = 256;
+    const int worldMin = (originX - radius) * Chunk::CHUNK_SIZE;
+    std::uniform_real_distribution<float> horizontal(0.0f, (float)(side * Chunk::CHUNK_SIZE) - 1.0f);
+    std::uniform_real_distribution<float> lift(-1.0f, 1.5f);
+    std::vector<glm::vec3> positions(4096);
+    for (glm::vec3& position : positions) {
+        position.x = (float)worldMin + horizontal(rng);
+        position.z = (float)((originZ - radius) * Chunk::CHUNK_SIZE) + horizontal(rng);
+        int y = Chunk::WORLD_HEIGHT - 1;
+        while (y > 0 && chunks.getBlock((int)std::floor(position.x), y, (int)std::floor(position.z)) == BLOCK_AIR) {
+            y--;
+        }
+        position.y = (float)(y + 1) + lift(rng);
+    }
+    Player player(positions[0]);
+    size_t collisions = 0;
+    samples.clear();
+    for (int repeat = 0; repeat < repeats; repeat++) {
+        for (size_t first = 0; first + batch <= positions.size(); first += batch) {
+            auto start = BenchClock::now();
+            for (size_t i = first; i < first + batch; i++) {
+                collisions += player.checkCollision(positions[i], chunks) ? 1 : 0;
+            }
+            samples.push_back(elapsedNs(start) / batch);
+        }
+    }
+    reportSamples("world", "Player::checkCollision", samples);
+    std::cout << "    " << collisions * 100 / (positions.size() * repeats) << "% of positions collide\n";
+
+    // 区块查找：随机坐标（含边界外约 1/8 的未加载坐标），每个样本是一批查找的平均
+    std::uniform_int_distribution<int> coord(-radius - 2, radius + 2);
+    std::vector<std::pair<int, int>> keys(4096);
+    for (auto& key : keys) {
+        key = {originX + coord(rng), originZ + coord(rng)};
+    }
+    samples.clear();
+    size_t found = 0;
+    for (int repeat = 0; repeat < repeats * 4; repeat++) {
+        for (size_t first = 0; first + batch <= keys.size(); first += batch) {
+            auto start = BenchClock::now();
+            for (size_t i = first; i < first + batch; i++) {
+                found += (chunks.find(keys[i].first, keys[i].second) != nullptr) ? 1 : 0;
+            }
+            samples.push_back(elapsedNs(start) / batch);
+        }
+    }
+    reportSamples("world", "ChunkMap::find", samples);
+    g_sink += found;
+
+    chunks.forEach([](int cx, int cz, Chunk* chunk) {
+        delete chunk;
+    });
+}
+
+// ---------------------------------------------------------------------------
+// 光照：区块内计算（工作线程）、加入世界时的边界传播、编辑后的增量更新，以及增量结果与从头计算是否一致
+// ---------------------------------------------------------------------------
+
+// 所有区块的光照与 reference 中保存的不同的格子数
+static size_t countLightMismatches(const ChunkMap& chunks, const std::map<std::pair<int, int>, std::vector<uint8_t>>& reference) {
+    size_t mismatches = 0;
+    chunks.forEach([&](int cx, int cz, Chunk* chunk) {
+        const std::vector<uint8_t>& saved = reference.at({cx, cz});
+        size_t i = 0;
+        for (int x = 0; x < Chunk::CHUNK_SIZE; x++) {
+            for (int y = 0; y < Chunk::WORLD_HEIGHT; y++) {
+                for (int z = 0; z < Chunk::CHUNK_SIZE; z++) {
+                    mismatches += (chunk->getLight(x, y, z) != saved[i++]) ? 1 : 0;
+                }
+            }
+        }
+    });
+    return mismatches;
+}
+
+static std::vector<uint8_t> saveLight(const Chunk& chunk) {
+    std::vector<uint8_t> light;
+    light.reserve(Chunk::CHUNK_SIZE * Chunk::WORLD_HEIGHT * Chunk::CHUNK_SIZE);
+    for (int x = 0; x < Chunk::CHUNK_SIZE; x++) {
+        for (int y = 0; y < Chunk::WORLD_HEIGHT; y++) {
+            for (int z = 0; z < Chunk::CHUNK_SIZE; z++) {
+                light.push_back(chunk.getLight(x, y, z));
+            }
+        }
+    }
+    return light;
+}
+
+static void benchLight() {
+    const int radius = 6;
+    ChunkMap chunks;
+    std::vector<Chunk*> order;
+    std::vector<double> chunkSamples;
+    size_t litSections = 0;
+    for (int cx = -radius; cx <= radius; cx++) {
+        for (int cz = -radius; cz <= radius; cz++) {
+            Chunk* chunk = new Chunk();
+            chunk->initData(cx, cz);
+            auto start = BenchClock::now();
+            LightEngine::lightChunk(*chunk);
+            chunkSamples.push_back(elapsedNs(start));
+            for (int s = 0; s < Chunk::SECTION_COUNT; s++) {
+                litSections += chunk->m_light[s].isUniform() ? 0 : 1;
+            }
+            order.push_back(chunk);
+        }
+    }
+    reportSamples("light", "lightChunk per chunk (worker)", chunkSamples);
+    std::cout << "  " << litSections << " of " << order.size() * Chunk::SECTION_COUNT
+              << " sections need a dense light array (" << litSections * LightStorage::VOLUME / 1024 << " KB)\n";
+
+    // 按加载顺序加入世界，每加入一个区块传播一次边界
+    std::vector<double> borderSamples;
+    size_t borderChanged = 0;
+    for (Chunk* chunk : order) {
+        chunks.insert(chunk->m_chunkX, chunk->m_chunkZ, chunk);
+        auto start = BenchClock::now();
+        borderChanged += LightEngine::propagateBorders(chunks, *chunk);
+        borderSamples.push_back(elapsedNs(start));
+    }
+    reportSamples("light", "propagateBorders per chunk, unbudgeted", borderSamples);
+    std::cout << "  border propagation changed " << borderChanged << " voxels\n";
+
+    // 编辑：地表放灯、拿走放过的灯、挖掉地表方块（向下挖出竖井）、在地表上放泥土（挡住天空光）
+    const char* kindNames[] = {"place lamp", "remove lamp", "dig", "place dirt"};
+    std::vector<glm::ivec3> lamps;
+    std::mt19937 rng(24);
+    std::uniform_int_distribution<int> coord(-(radius - 1) * Chunk::CHUNK_SIZE, radius * Chunk::CHUNK_SIZE - 1);
+    // 选出下一次编辑（kind < 0 时随机选种类），返回种类
+    auto nextEdit = [&](int kind, glm::ivec3& p, uint16_t& type) {
+        if (kind < 0) {
+            kind = (int)(rng() % 4);
+        }
+        if (kind == 1 && lamps.empty()) {
+            kind = 0;
+        }
+        if (kind == 1) {
+            size_t pick = rng() % lamps.size();
+            p = lamps[pick];
+            lamps[pick] = lamps.back();
+            lamps.pop_back();
+            type = BLOCK_AIR;
+            return kind;
+        }
+        p.x = coord(rng);
+        p.z = coord(rng);
+        p.y = Chunk::WORLD_HEIGHT - 1;
+        while (p.y > 0 && chunks.getBlock(p.x, p.y, p.z) == BLOCK_AIR) {
+            p.y--;
+        }
+        if (kind == 0 || kind == 3) {
+            p.y++;
+        }
+        type = (kind == 0) ? BLOCK_LAMP : (kind == 2) ? BLOCK_AIR : BLOCK_DIRT;
+        if (kind == 0) {
+            lamps.push_back(p);
+        }
+        return kind;
+    };
+
+    // 一次编辑的全部传播（不限时间）：即每次编辑的 BFS 工作量
+    std::vector<double> editSamples[4];
+    size_t editChanged = 0;
+    for (int i = 0; i < 4000; i++) {
+        glm::ivec3 p;
+        uint16_t type;
+        int kind = nextEdit(-1, p, type);
+        uint16_t oldType = chunks.getBlock(p.x, p.y, p.z);
+        auto start = BenchClock::now();
+        chunks.setBlock(p.x, p.y, p.z, type);
+        editChanged += LightEngine::updateBlock(chunks, p.x, p.y, p.z, oldType);
+        editSamples[kind].push_back(elapsedNs(start));
+    }
+    for (int kind = 0; kind < 4; kind++) {
+        std::string metric = std::string("setBlock + updateBlock unbudgeted, ") + kindNames[kind];
+        reportSamples("light", metric.c_str(), editSamples[kind]);
+    }
+    std::cout << "  edits changed " << editChanged << " voxels, " << lamps.size() << " lamps left\n";
+
+    // 游戏中的用法（ChunkStreamer）：编辑只放入种子，每帧在时间预算内推进传播，剩下的留到下一帧
+    // 每帧放一盏灯、拿走一盏灯，预算 0.25 ms（比一盏灯的全部传播还短，测的是剩余工作留到下一帧的情况）；
+    // 主线程每帧的时间 = 编辑 + 放入种子 + process
+    {
+        LightEngine engine(chunks);
+        const double frameBudget = 0.00025;
+        const int editFrames = 300;
+        std::vector<double> frameSamples;
+        double maxFrameNs = 0.0;
+        int carriedFrames = 0;   // 用完预算、剩余工作留到下一帧的帧数
+        int settleFrames = 0;
+        for (int frame = 0; frame < editFrames || !engine.idle(); frame++) {
+            auto start = BenchClock::now();
+            for (int kind = 0; kind < 2 && frame < editFrames; kind++) {
+                glm::ivec3 p;
+                uint16_t type;
+                nextEdit(kind, p, type);
+                uint16_t oldType = chunks.getBlock(p.x, p.y, p.z);
+                chunks.setBlock(p.x, p.y, p.z, type);
+                engine.queueBlockUpdate(p.x, p.y, p.z, oldType);
+            }
+            engine.process(frameBudget);
+            double ns = elapsedNs(start);
+            frameSamples.push_back(ns);
+            maxFrameNs = std::max(maxFrameNs, ns);
+            carriedFrames += engine.idle() ? 0 : 1;
+            settleFrames += (frame >= editFrames) ? 1 : 0;
+        }
+        reportSamples("light", "main thread per frame, 1 lamp placed + 1 removed, 0.25 ms budget", frameSamples);
+        std::cout << "  max frame " << maxFrameNs / 1e6 << " ms, " << carriedFrames << " of " << frameSamples.size()
+                  << " frames left work for the next frame, " << settleFrames << " extra frames after the last edit\n";
+    }
+
+    // 增量更新的结果应与按最终方块从头计算的结果完全相同
+    std::map<std::pair<int, int>, std::vector<uint8_t>> incremental;
+    for (Chunk* chunk : order) {
+        incremental[{chunk->m_chunkX, chunk->m_chunkZ}] = saveLight(*chunk);
+    }
+    for (Chunk* chunk : order) {
+        LightEngine::lightChunk(*chunk);
+    }
+    for (Chunk* chunk : order) {
+        LightEngine::propagateBorders(chunks, *chunk);
+    }
+    std::cout << "  incremental vs full relight: " << countLightMismatches(chunks, incremental)
+              << " mismatched voxels\n";
+
+    // 卸载：在中间区块的边界内侧放一圈灯，传到相邻区块后卸载它；相邻区块中从它传过来的光应被清掉，
+    // 结果与不含它的世界从头计算的光照相同
+    {
+        const int N = Chunk::CHUNK_SIZE;
+        Chunk* center = chunks.find(0, 0);
+        for (int i = 0; i < N; i += 3) {
+            for (const glm::ivec2& edge : {glm::ivec2(0, i), glm::ivec2(N - 1, i), glm::ivec2(i, 0), glm::ivec2(i, N - 1)}) {
+                int y = Chunk::WORLD_HEIGHT - 1;
+                while (y > 0 && chunks.getBlock(edge.x, y, edge.y) == BLOCK_AIR) {
+                    y--;
+                }
+                uint16_t oldType = chunks.getBlock(edge.x, y + 1, edge.y);
+                chunks.setBlock(edge.x, y + 1, edge.y, BLOCK_LAMP);
+                LightEngine::updateBlock(chunks, edge.x, y + 1, edge.y, oldType);
+            }
+        }
+        chunks.erase(0, 0);
+        order.erase(std::find(order.begin(), order.end(), center));
+
+        std::map<std::pair<int, int>, std::vector<uint8_t>> stale;
+        for (Chunk* chunk : order) {
+            stale[{chunk->m_chunkX, chunk->m_chunkZ}] = saveLight(*chunk);
+        }
+        LightEngine engine(chunks);
+        auto start = BenchClock::now();
+        engine.queueUnload(*center);
+        double queueUs = elapsedNs(start) / 1e3;
+        size_t cleared = engine.process(-1.0);
+        double unloadUs = elapsedNs(start) / 1e3;
+        std::map<std::pair<int, int>, std::vector<uint8_t>> unloaded;
+        for (Chunk* chunk : order) {
+            unloaded[{chunk->m_chunkX, chunk->m_chunkZ}] = saveLight(*chunk);
+        }
+        delete center;
+
+        for (Chunk* chunk : order) {
+            LightEngine::lightChunk(*chunk);
+        }
+        for (Chunk* chunk : order) {
+            LightEngine::propagateBorders(chunks, *chunk);
+        }
+        std::cout << "  unload a chunk with lamps on its border: queueUnload " << queueUs << " us, " << cleared
+                  << " voxels changed in " << unloadUs << " us total; vs full relight without it: " << countLightMismatches(chunks, unloaded)
+                  << " mismatched voxels (" << countLightMismatches(chunks, stale) << " if its light is kept)\n";
+    }
+
+    for (Chunk* chunk : order) {
+        delete chunk;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 昼夜循环：渲染器每帧把 DayCycle::skyBrightness 写入着色器的 uniform，检查它在各个时刻的值
+// （期望值按 DayCycle 注释中的定义手算），以及走完一整天的过程中亮度先升后降、时间回到起点
+// ---------------------------------------------------------------------------
+
+static void benchDayCycle() {
+    // 时刻 -> 期望的天空亮度：午夜和深夜为最低亮度；日出日落时太阳高度 0，
+    // daylight = smoothstep((0 + 0.2) / 0.5) = 0.4^2 * (3 - 0.8) = 0.352，亮度 0.2 + 0.8 * 0.352 = 0.4816；
+    // 太阳高度超过 0.3（0.3 以后）全亮，低于 -0.2（日落后 0.032 天以后）为最低亮度
+    struct Expected {
+        float time;
+        float brightness;
+    };
+    const Expected expected[] = {
+        {0.0f, 0.2f}, {0.1f, 0.2f}, {0.25f, 0.4816f}, {0.3f, 1.0f}, {0.5f, 1.0f},
+        {0.75f, 0.4816f}, {0.8f, 0.2f}, {1.0f, 0.2f}, {-0.5f, 1.0f},
+    };
+    int checks = 0;
+    int failed = 0;
+    auto check = [&](bool ok, const std::string& what) {
+        checks++;
+        if (!ok) {
+            failed++;
+            std::cout << "  FAILED: " << what << "\n";
+        }
+    };
+    for (const Expected& e : expected) {
+        DayCycle dayCycle(e.time);
+        float brightness = dayCycle.skyBrightness();
+        check(std::fabs(brightness - e.brightness) < 1e-3f,
+              "skyBrightness at time " + std::to_string(e.time) + " is " + std::to_string(brightness) +
+              ", expected " + std::to_string(e.brightness));
+    }
+
+    // 一天分成 1440 帧（每帧一游戏分钟）：午夜到正午不变暗，正午到午夜不变亮，最后回到起点
+    DayCycle dayCycle(0.0f);
+    const int FRAMES = 1440;
+    std::vector<double> samples;
+    std::vector<float> brightness;
+    for (int frame = 0; frame < FRAMES; frame++) {
+        auto start = BenchClock::now();
+        dayCycle.advance(DayCycle::DAY_SECONDS / FRAMES);
+        brightness.push_back(dayCycle.skyBrightness());
+        samples.push_back(elapsedNs(start));
+    }
+    int wrongDirection = 0;
+    for (int frame = 1; frame < FRAMES; frame++) {
+        bool morning = frame <= FRAMES / 2;
+        float delta = brightness[frame] - brightness[frame - 1];
+        wrongDirection += (morning ? delta < -1e-6f : delta > 1e-6f) ? 1 : 0;
+    }
+    float minBrightness = *std::min_element(brightness.begin(), brightness.end());
+    float maxBrightness = *std::max_element(brightness.begin(), brightness.end());
+    float endTime = dayCycle.timeOfDay();
+    check(wrongDirection == 0, std::to_string(wrongDirection) + " frames brighten after noon or darken before it");
+    check(std::fabs(minBrightness - DayCycle::MIN_SKY_BRIGHTNESS) < 1e-3f && std::fabs(maxBrightness - 1.0f) < 1e-3f,
+          "brightness range over the day " + std::to_string(minBrightness) + " .. " + std::to_string(maxBrightness));
+    check(std::min(endTime, 1.0f - endTime) < 1e-3f, "time after a full day is " + std::to_string(endTime));
+
+    reportSamples("daycycle", "time step + sky brightness per frame", samples);
+    std::cout << "  full day over " << FRAMES << " frames: sky brightness " << minBrightness << " .. " << maxBrightness
+              << ", time back to " << endTime << "\n";
+    std::cout << "  " << checks - failed << " of " << checks << " checks passed\n";
+}
+
+// ---------------------------------------------------------------------------
+
+struct BenchEntry {
+    const char* name;
+    const char* description;
+    std::function<void()> run;
+};
+
+int main(int argc, char** argv) {
+    std::vector<BenchEntry> benches = {
+        {"chunkmap", "ChunkMap vs std::map chunk lookup", benchChunkMap},
+        {"meshing", "naive vs greedy meshing on Perlin terrain", benchMeshing},
+        {"pipeline", "threaded chunk generation and meshing", benchPipeline},
+        {"frustum", "view-frustum culling ratio", benchFrustum},
+        {"storage", "palette block storage memory and access", benchBlockStorage},
+        {"noise", "batched SIMD fBm vs stb_perlin", benchNoise},
+        {"streaming", "chunk streaming while sprinting", benchStreaming},
+        {"collision", "swept-AABB player collision", benchCollision},
+        {"raycast", "voxel DDA raycast throughput", benchRaycast},
+        {"edits", "block edits with incremental remeshing", benchEdits},
+        {"region", "region file full and delta saves vs terrain generation", benchRegion},
+        {"io", "asynchronous chunk I/O while sprinting", benchIO},
+        {"mmap", "mmap vs buffered region reads", benchMmap},
+        {"profiler", "profiler zone overhead and trace export", benchProfiler},
+        {"world", "worldgen, meshing, collision and lookups with min/median/p99", benchWorld},
+        {"light", "sky/block light propagation and incremental updates", benchLight},
+        {"daycycle", "day/night sky brightness at set times and over a full day", benchDayCycle},
+    };
+
+    std::vector<std::string> selectedNames;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--radius" && hasValue) {
+            g_options.worldRadius = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--seed" && hasValue) {
+            g_options.seed = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--repeats" && hasValue) {
+            g_options.repeats = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--json" && hasValue) {
+            g_options.jsonPath = argv[++i];
+        } else if (arg.compare(0, 2, "--") == 0) {
+            std::cerr << "unknown or incomplete option " << arg << "\n";
+            return 1;
+        } else {
+            selectedNames.push_back(arg);
+        }
+    }
+
+    for (const BenchEntry& bench : benches) {
+        bool selected = selectedNames.empty() ||
+                        std::find(selectedNames.begin(), selectedNames.end(), bench.name) != selectedNames.end();
+        if (!selected) {
+            continue;
+        }
+        std::cout << "[" << bench.name << "] " << bench.description << std::endl;
+        bench.run();
+    }
+
+    if (!g_options.jsonPath.empty()) {
+        if (!writeResultsJson(g_options.jsonPath)) {
+            std::cerr << "failed to write " << g_options.jsonPath << "\n";
+            return 1;
+        }
+        std::cout << "results written to " << g_options.jsonPath << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,251 @@
+#ifndef BLOCK_STORAGE_H
+#define BLOCK_STORAGE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// 调色板压缩的 16^3 方块存储
+// 每个区块维护一个调色板（出现过的方块类型），方块本身只存调色板下标，
+// 下标按调色板大小使用 0/1/2/4/8/16 位紧密打包在 uint64 中（位宽是 2 的幂，不会跨字）
+// 位宽为 0 表示整个区块只有一种方块（全空气、全石头），只存调色板的一个值
+// 方块类型为 16 位，不再受 256 种的限制
+// 复制时共享数据（写时复制）：网格任务在主线程上只复制存储对象（引用计数加一），在工作线程上展开；
+// 之后主线程再写入时发现数据被共享，先复制一份再改，工作线程读到的快照不会变
+class BlockStorage {
+public:
+    static const int SIZE = 16;
+    static const int VOLUME = SIZE * SIZE * SIZE;
+
+    // 全空气的存储共享同一份数据，构造时不分配内存（网格快照中缺少的段都是这样）
+    explicit BlockStorage(uint16_t fillValue = 0) : m_bits(0) {
+        if (fillValue == 0) {
+            m_data = airData();
+        } else {
+            m_data = std::make_shared<Data>();
+            m_data->palette.push_back(fillValue);
+        }
+    }
+
+    // 下标布局与原先的 m_blocks[x][y][z] 一致
+    static int index(int x, int y, int z) {
+        return (x * SIZE + y) * SIZE + z;
+    }
+
+    uint16_t get(int x, int y, int z) const {
+        return getIndex(index(x, y, z));
+    }
+
+    uint16_t getIndex(int i) const {
+        const Data& data = *m_data;
+        if (m_bits == 0) {
+            return data.palette[0];
+        }
+        int bit = i * m_bits;
+        uint64_t word = data.words[bit >> 6];
+        uint32_t paletteIndex = (uint32_t)(word >> (bit & 63)) & ((1u << m_bits) - 1);
+        return data.palette[paletteIndex];
+    }
+
+    void set(int x, int y, int z, uint16_t value) {
+        setIndex(index(x, y, z), value);
+    }
+
+    void setIndex(int i, uint16_t value) {
+        int paletteIndex = findPalette(value);
+        if (paletteIndex < 0) {
+            Data& data = mutableData();
+            paletteIndex = (int)data.palette.size();
+            data.palette.push_back(value);
+            if (bitsFor(data.palette.size()) != m_bits) {
+                resize(bitsFor(data.palette.size()));
+            }
+        }
+        if (m_bits == 0) {
+            return;   // 调色板只有一项时无需写入下标
+        }
+        if (readIndex(i) != (uint32_t)paletteIndex) {
+            mutableData();
+            writeIndex(i, (uint32_t)paletteIndex);
+        }
+    }
+
+    // 整个区块填充为同一种方块（回到单值快速路径）
+    void fill(uint16_t value) {
+        Data& data = replaceData();
+        data.palette.assign(1, value);
+        data.words.clear();
+        data.words.shrink_to_fit();
+        m_bits = 0;
+    }
+
+    // 一次性写入整个区块（下标布局同 index()），只建一次调色板，比逐个 set 快得多
+    template <typename T>
+    void assign(const T* dense) {
+        Data& data = replaceData();
+        data.palette.clear();
+        // 调色板查找表：方块类型 -> 调色板下标 + 1
+        std::vector<uint16_t> lookup;
+        std::vector<uint16_t> indices(VOLUME);
+        for (int i = 0; i < VOLUME; i++) {
+            uint16_t value = (uint16_t)dense[i];
+            if (value >= lookup.size()) {
+                lookup.resize((size_t)value + 1, 0);
+            }
+            if (lookup[value] == 0) {
+                data.palette.push_back(value);
+                lookup[value] = (uint16_t)data.palette.size();
+            }
+            indices[i] = lookup[value] - 1;
+        }
+
+        m_bits = bitsFor(data.palette.size());
+        data.words.assign(wordCount(m_bits), 0);
+        data.words.shrink_to_fit();
+        if (m_bits != 0) {
+            for (int i = 0; i < VOLUME; i++) {
+                writeIndex(i, indices[i]);
+            }
+        }
+    }
+
+    // 展开为稠密数组（下标布局同 index()）
+    template <typename T>
+    void copyTo(T* dense) const {
+        if (m_bits == 0) {
+            for (int i = 0; i < VOLUME; i++) {
+                dense[i] = (T)m_data->palette[0];
+            }
+            return;
+        }
+        for (int i = 0; i < VOLUME; i++) {
+            dense[i] = (T)getIndex(i);
+        }
+    }
+
+    // 去掉调色板中已不再使用的项，必要时缩小位宽（大量编辑后调用）
+    void compact() {
+        std::vector<uint16_t> dense(VOLUME);
+        copyTo(dense.data());
+        assign(dense.data());
+    }
+
+    // 直接设置调色板和打包好的下标（用于从存档读取）；位宽与调色板大小或数据长度不符时返回 false
+    bool assignPacked(std::vector<uint16_t> palette, int bits, std::vector<uint64_t> words) {
+        if (palette.empty() || bits != bitsFor(palette.size()) || words.size() != wordCount(bits)) {
+            return false;
+        }
+        Data& data = replaceData();
+        data.palette.swap(palette);
+        data.words.swap(words);
+        m_bits = bits;
+        return true;
+    }
+
+    // 整个区块是否只有一种方块
+    bool isUniform() const { return m_bits == 0; }
+    uint16_t uniformValue() const { return m_data->palette[0]; }
+
+    int bitsPerBlock() const { return m_bits; }
+    size_t paletteSize() const { return m_data->palette.size(); }
+    const std::vector<uint16_t>& palette() const { return m_data->palette; }
+    const std::vector<uint64_t>& words() const { return m_data->words; }
+
+    // 方块数据占用的堆内存（不含对象本身；与快照共享时也按整份计算）
+    size_t memoryUsage() const {
+        return m_data->words.capacity() * sizeof(uint64_t) + m_data->palette.capacity() * sizeof(uint16_t);
+    }
+
+private:
+    struct Data {
+        std::vector<uint64_t> words;     // 打包的调色板下标
+        std::vector<uint16_t> palette;   // 调色板：下标 -> 方块类型
+    };
+
+    static const std::shared_ptr<Data>& airData() {
+        static const std::shared_ptr<Data> air = std::make_shared<Data>(Data{{}, {0}});
+        return air;
+    }
+
+    // 要原地修改数据：与其他对象（快照）共享时先复制一份
+    // 引用计数为 1 时，其他线程释放快照的递减（release）经过 acquire 栅栏与这里同步，之后的写入不会与它的读取重叠
+    Data& mutableData() {
+        if (m_data.use_count() > 1) {
+            m_data = std::make_shared<Data>(*m_data);
+        } else {
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return *m_data;
+    }
+
+    // 要整体替换数据：共享时换成新的空数据，不必复制旧内容
+    Data& replaceData() {
+        if (m_data.use_count() > 1) {
+            m_data = std::make_shared<Data>();
+        } else {
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return *m_data;
+    }
+
+    static int bitsFor(size_t paletteSize) {
+        if (paletteSize <= 1) return 0;
+        if (paletteSize <= 2) return 1;
+        if (paletteSize <= 4) return 2;
+        if (paletteSize <= 16) return 4;
+        if (paletteSize <= 256) return 8;
+        return 16;
+    }
+
+    static size_t wordCount(int bits) {
+        return (size_t)VOLUME * bits / 64;
+    }
+
+    int findPalette(uint16_t value) const {
+        const std::vector<uint16_t>& palette = m_data->palette;
+        for (size_t i = 0; i < palette.size(); i++) {
+            if (palette[i] == value) {
+                return (int)i;
+            }
+        }
+        return -1;
+    }
+
+    uint32_t readIndex(int i) const {
+        int bit = i * m_bits;
+        return (uint32_t)(m_data->words[bit >> 6] >> (bit & 63)) & ((1u << m_bits) - 1);
+    }
+
+    // 调用前数据必须已经独占（mutableData / replaceData）
+    void writeIndex(int i, uint32_t paletteIndex) {
+        int bit = i * m_bits;
+        uint64_t mask = ((uint64_t)1 << m_bits) - 1;
+        uint64_t& word = m_data->words[bit >> 6];
+        word = (word & ~(mask << (bit & 63))) | ((uint64_t)paletteIndex << (bit & 63));
+    }
+
+    // 改变位宽并重新打包已有的下标（数据已经独占）
+    void resize(int newBits) {
+        std::vector<uint64_t> oldWords;
+        oldWords.swap(m_data->words);
+        int oldBits = m_bits;
+
+        m_bits = newBits;
+        m_data->words.assign(wordCount(newBits), 0);
+        for (int i = 0; i < VOLUME; i++) {
+            uint32_t paletteIndex = 0;
+            if (oldBits != 0) {
+                int bit = i * oldBits;
+                paletteIndex = (uint32_t)(oldWords[bit >> 6] >> (bit & 63)) & ((1u << oldBits) - 1);
+            }
+            writeIndex(i, paletteIndex);
+        }
+    }
+
+    int m_bits;                     // 每个方块的位数：0/1/2/4/8/16
+    std::shared_ptr<Data> m_data;   // 与快照共享，写入前 mutableData 取得独占
+};
+
+#endif
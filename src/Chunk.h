@@ -1,110 +1,454 @@
 #ifndef CHUNK_H
 #define CHUNK_H
 
-#include <glad/glad.h>
 #include <vector>
 #include <cstdint>
-#include <stb_perlin.h>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include "PerlinBatch.h"
+#include "BlockStorage.h"
+#include "LightStorage.h"
+#include "MeshArena.h"
+#include "Profiler.h"
+
+// 网格生成方式
+enum MeshMode {
+    MESH_NAIVE = 0,   // 每个暴露的面一个四边形
+    MESH_GREEDY = 1   // 合并同一平面内相同方块的面
+};
+
+// 相邻区块方向（opposite = dir ^ 1）
+enum ChunkNeighbor {
+    NEIGHBOR_NEG_X = 0,
+    NEIGHBOR_POS_X = 1,
+    NEIGHBOR_NEG_Z = 2,
+    NEIGHBOR_POS_Z = 3
+};
 
 // 方块类型
-enum BlockType : uint8_t {
+enum BlockType : uint16_t {
     BLOCK_AIR = 0,
     BLOCK_STONE = 1,
     BLOCK_DIRT = 2,
-    BLOCK_GRASS = 3
+    BLOCK_GRASS = 3,
+    BLOCK_LAMP = 4    // 发光方块（方块光 15）
+};
+
+// 方块是否挡光（目前除空气外都是实心方块）
+inline bool isOpaqueBlock(uint16_t blockType) {
+    return blockType != BLOCK_AIR;
+}
+
+// 方块发出的方块光等级（0 ~ 15）
+inline int blockLightEmission(uint16_t blockType) {
+    return (blockType == BLOCK_LAMP) ? 15 : 0;
+}
+
+// 区块在竖直方向上的一段（16^3），有自己的方块数据和网格
+// 全空气的段不分配（Chunk::m_sections 中为 nullptr），也不生成网格
+struct ChunkSection {
+    // 存储方块数据：调色板压缩，全石头的段只占几个字节
+    BlockStorage blocks;
+
+    // 专门用来存"生成好的顶点"，发给 GPU 用；上传后释放（GPU 上已有一份），只在等待上传时占用内存
+    std::vector<uint32_t> vertices;
+
+    // 网格在共享顶点缓冲（MeshArena）中的位置，由 MeshArena::upload/release 维护
+    MeshArena::Allocation mesh;
+
+    // 网格需要重建（新段，或相邻区块加载/卸载导致边界面的可见性变化）
+    bool meshDirty = true;
+
+    // 网格请求版本号：后台网格任务完成时只接受最新一次请求的结果
+    uint32_t meshVersion = 0;
+
+    // 正在后台进行的网格任务数；不为 0 时新的修改只保留脏标记，等当前任务完成后再合并成一次重建
+    int meshJobsInFlight = 0;
 };
 
+// 一列区块：水平 16x16，竖直方向由 SECTION_COUNT 个 16^3 的段堆叠而成
 class Chunk {
 public:
     static const int CHUNK_SIZE = 16;
+    static const int SECTION_COUNT = 16;                           // 段数
+    static const int WORLD_HEIGHT = CHUNK_SIZE * SECTION_COUNT;    // 世界高度 256
+
+    // 顶点打包格式（每个顶点 4 字节）：
+    // bit 0-4 x, 5-9 y, 10-14 z（段内坐标 0~16），15-17 面方向, 18-21 atlas 贴图索引,
+    // 22-23 环境光遮蔽（0 最暗 ~ 3 不遮蔽）, 24-27 方块光, 28-31 天空光（面前方那一格的光照，打包同 LightStorage）
+    static const int VERTEX_Y_SHIFT = 5;
+    static const int VERTEX_Z_SHIFT = 10;
+    static const int VERTEX_FACE_SHIFT = 15;
+    static const int VERTEX_TEX_SHIFT = 18;
+    static const int VERTEX_AO_SHIFT = 22;
+    static const int VERTEX_LIGHT_SHIFT = 24;
+
+    // 每个面方向的法线，以及 {法线轴, u轴, v轴}（0=x, 1=y, 2=z）
+    // face: 0=前(z+), 1=后(z-), 2=左(x-), 3=右(x+), 4=底(y-), 5=顶(y+)
+    static constexpr int FACE_NORMALS[6][3] = {
+        {0, 0, 1}, {0, 0, -1}, {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}
+    };
+    static constexpr int FACE_AXES[6][3] = {
+        {2, 0, 1}, {2, 0, 1}, {0, 2, 1}, {0, 2, 1}, {1, 0, 2}, {1, 0, 2}
+    };
+
+    // 所有区块使用的网格生成方式（保留逐面网格便于对比）
+    static inline MeshMode s_meshMode = MESH_GREEDY;
     
-    // 存储方块数据：16*16*16 = 4096 个字节
-    uint8_t m_blocks[CHUNK_SIZE][CHUNK_SIZE][CHUNK_SIZE];
-    
-    // 专门用来存"生成好的顶点"，发给 GPU 用
-    std::vector<float> m_vertices;
-    
-    unsigned int VAO, VBO;
-    
-    Chunk() : VAO(0), VBO(0) {
-        // 初始化所有方块为空气
-        for (int x = 0; x < CHUNK_SIZE; x++) {
-            for (int y = 0; y < CHUNK_SIZE; y++) {
-                for (int z = 0; z < CHUNK_SIZE; z++) {
-                    m_blocks[x][y][z] = BLOCK_AIR;
+    // 竖直方向的各段，下标 = y / CHUNK_SIZE；全空气的段为 nullptr（通过 getBlock/setBlock 访问方块）
+    std::unique_ptr<ChunkSection> m_sections[SECTION_COUNT];
+
+    // 各段的光照（全空气的段也有，例如悬空结构下面的阴影），由 LightEngine 计算；
+    // 还没计算过光照的区块全部为 15 级天空光
+    LightStorage m_light[SECTION_COUNT];
+
+    // 区块坐标（由 initData 设置）
+    int m_chunkX, m_chunkZ;
+
+    // 四个方向的相邻区块，由 ChunkMap 在插入/删除时维护；未加载时为 nullptr
+    Chunk* m_neighbors[4];
+
+    // 已提交、结果还没被 ChunkPipeline::processCompleted 取走的网格任务数
+    // 不为 0 时区块不能释放（完成队列里的结果还引用着它）
+    int m_pendingMeshJobs;
+
+    // 方块数据与存档不一致，卸载时需要写回（新生成或被编辑过；从存档读取的区块为 false）
+    bool m_needsSave;
+
+    // 方块可能与 initData 生成的地形不同（被编辑过，或从存档读取了修改）；增量存档只需保存这样的区块
+    bool m_hasEdits;
+
+    // 网格生成用的方块快照：一个段本身加上外面一圈（取自上下相邻的段、相邻区块和对角的区块），共 18^3
+    // 这样边界面也能按真实数据剔除、环境光遮蔽也能读到边界外的方块，生成网格时也不必再判断越界
+    // light 为同样范围的光照（打包同 LightStorage），面的亮度取面前方那一格
+    struct PaddedBlocks {
+        static const int SIZE = CHUNK_SIZE + 2;
+        uint16_t data[SIZE][SIZE][SIZE];
+        uint8_t light[SIZE][SIZE][SIZE];
+
+        // 坐标范围 -1 ~ CHUNK_SIZE
+        uint16_t get(int x, int y, int z) const {
+            return data[x + 1][y + 1][z + 1];
+        }
+        bool isAir(int x, int y, int z) const {
+            return get(x, y, z) == BLOCK_AIR;
+        }
+        uint8_t getLight(int x, int y, int z) const {
+            return light[x + 1][y + 1][z + 1];
+        }
+
+        // 段内和六个方向的边界层都没有空气（例如深埋地下的全石头段），不会有任何可见面
+        // 棱和角上的格子网格生成不会读取，不参与判断
+        bool isEnclosed() const {
+            for (int x = 0; x < SIZE; x++) {
+                for (int y = 0; y < SIZE; y++) {
+                    for (int z = 0; z < SIZE; z++) {
+                        int borders = (x == 0 || x == SIZE - 1) + (y == 0 || y == SIZE - 1) + (z == 0 || z == SIZE - 1);
+                        if (borders < 2 && data[x][y][z] == BLOCK_AIR) {
+                            return false;
+                        }
+                    }
                 }
             }
+            return true;
         }
-    }
+    };
+
+    // 网格任务在主线程上拍下的快照：这个段周围 3x3x3 个段的方块和光照存储，下标 [dx + 1][dy + 1][dz + 1]
+    // 存储是写时复制的，拍快照只增加引用计数；在工作线程上用 expandSnapshot 展开成 PaddedBlocks
+    // 快照不引用任何区块，之后区块被编辑或卸载都不影响它
+    // 没有的段按 getBlock / getLight 的约定：未加载的区块、空段和世界上方为空气（光照取区块的光照，未加载为满天空光），
+    // 世界下方为全黑，其中本区块那一列为石头（底面永远看不到）
+    struct SectionSnapshot {
+        BlockStorage blocks[3][3][3];
+        LightStorage light[3][3][3];
+    };
     
-    ~Chunk() {
-        if (VAO != 0) {
-            glDeleteVertexArrays(1, &VAO);
-            glDeleteBuffers(1, &VBO);
+    Chunk() : m_chunkX(0), m_chunkZ(0), m_pendingMeshJobs(0), m_needsSave(false), m_hasEdits(false) {
+        // 所有段默认未分配（全部为空气）
+        for (int i = 0; i < 4; i++) {
+            m_neighbors[i] = nullptr;
+        }
+    }
+
+    // 区块内坐标的方块：x/z 为 0 ~ CHUNK_SIZE-1，y 为 0 ~ WORLD_HEIGHT-1（超出范围视为空气）
+    uint16_t getBlock(int x, int y, int z) const {
+        if (y < 0 || y >= WORLD_HEIGHT) {
+            return BLOCK_AIR;
+        }
+        const ChunkSection* section = m_sections[y / CHUNK_SIZE].get();
+        if (section == nullptr) {
+            return BLOCK_AIR;
+        }
+        return section->blocks.get(x, y % CHUNK_SIZE, z);
+    }
+
+    void setBlock(int x, int y, int z, uint16_t blockType) {
+        if (y < 0 || y >= WORLD_HEIGHT) {
+            return;
+        }
+        std::unique_ptr<ChunkSection>& section = m_sections[y / CHUNK_SIZE];
+        if (section == nullptr) {
+            if (blockType == BLOCK_AIR) {
+                return;
+            }
+            section.reset(new ChunkSection());
+        }
+        section->blocks.set(x, y % CHUNK_SIZE, z, blockType);
+    }
+
+    ChunkSection* getSection(int sectionIndex) const {
+        return m_sections[sectionIndex].get();
+    }
+
+    // 区块内坐标的光照（打包同 LightStorage）：世界顶部以上为 15 级天空光，底部以下全黑
+    uint8_t getLight(int x, int y, int z) const {
+        if (y < 0) {
+            return 0;
+        }
+        if (y >= WORLD_HEIGHT) {
+            return LightStorage::FULL_SKY;
+        }
+        return m_light[y / CHUNK_SIZE].get(x, y % CHUNK_SIZE, z);
+    }
+
+    void setLight(int x, int y, int z, uint8_t light) {
+        if (y >= 0 && y < WORLD_HEIGHT) {
+            m_light[y / CHUNK_SIZE].set(x, y % CHUNK_SIZE, z, light);
+        }
+    }
+
+    // 一个段的网格需要重建（段未分配或超出范围时忽略）
+    void markSectionDirty(int sectionIndex) {
+        if (sectionIndex >= 0 && sectionIndex < SECTION_COUNT && m_sections[sectionIndex] != nullptr) {
+            m_sections[sectionIndex]->meshDirty = true;
+        }
+    }
+
+    // 所有已分配段的网格都需要重建（相邻区块加载/卸载后边界面的可见性会变化）
+    void markAllMeshesDirty() {
+        for (int s = 0; s < SECTION_COUNT; s++) {
+            if (m_sections[s] != nullptr) {
+                m_sections[s]->meshDirty = true;
+            }
         }
     }
     
     // 使用柏林噪声生成地形（需要传入区块世界坐标）
     void initData(int chunkX = 0, int chunkZ = 0) {
+        PROFILE_ZONE("Chunk::initData");
         // 噪声参数
         const float scale = 0.05f;      // 噪声缩放（越小地形越平缓）
-        const int baseHeight = 8;       // 基础地形高度
-        const int heightRange = 6;      // 高度变化范围
-        
+        const int baseHeight = 64;      // 基础地形高度
+        const int heightRange = 12;     // 高度变化范围
+
+        m_chunkX = chunkX;
+        m_chunkZ = chunkZ;
+        m_needsSave = true;
+        m_hasEdits = false;
+        for (int s = 0; s < SECTION_COUNT; s++) {
+            m_light[s].fill(LightStorage::FULL_SKY);   // 光照由 LightEngine::lightChunk 重新计算
+        }
+
+        // 先算出每一列的地表高度：256 列的噪声一次批量计算（SIMD）
+        float sampleX[CHUNK_SIZE * CHUNK_SIZE];
+        float sampleY[CHUNK_SIZE * CHUNK_SIZE];
+        float sampleZ[CHUNK_SIZE * CHUNK_SIZE];
+        float noise[CHUNK_SIZE * CHUNK_SIZE];
         for (int x = 0; x < CHUNK_SIZE; x++) {
             for (int z = 0; z < CHUNK_SIZE; z++) {
                 // 计算世界坐标
                 float worldX = (float)(chunkX * CHUNK_SIZE + x);
                 float worldZ = (float)(chunkZ * CHUNK_SIZE + z);
-                
-                // 使用柏林噪声计算地形高度
-                float noiseValue = stb_perlin_fbm_noise3(
-                    worldX * scale, 
-                    0.0f, 
-                    worldZ * scale, 
-                    2.0f,   // lacunarity
-                    0.5f,   // gain
-                    4       // octaves
-                );
-                
+                sampleX[x * CHUNK_SIZE + z] = worldX * scale;
+                sampleY[x * CHUNK_SIZE + z] = 0.0f;
+                sampleZ[x * CHUNK_SIZE + z] = worldZ * scale;
+            }
+        }
+        perlinFbmNoise3Batch(sampleX, sampleY, sampleZ, noise, CHUNK_SIZE * CHUNK_SIZE,
+                             2.0f,   // lacunarity
+                             0.5f,   // gain
+                             4);     // octaves
+
+        int heights[CHUNK_SIZE][CHUNK_SIZE];
+        int maxHeight = 0;
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            for (int z = 0; z < CHUNK_SIZE; z++) {
                 // 将噪声值(-1到1)映射到高度
-                int terrainHeight = baseHeight + (int)(noiseValue * heightRange);
+                int terrainHeight = baseHeight + (int)(noise[x * CHUNK_SIZE + z] * heightRange);
                 terrainHeight = (terrainHeight < 1) ? 1 : terrainHeight;
-                terrainHeight = (terrainHeight >= CHUNK_SIZE) ? CHUNK_SIZE - 1 : terrainHeight;
-                
-                for (int y = 0; y < CHUNK_SIZE; y++) {
-                    if (y > terrainHeight) {
-                        // 地表以上是空气
-                        m_blocks[x][y][z] = BLOCK_AIR;
-                    } else if (y == terrainHeight) {
-                        // 最顶层是泥土
-                        m_blocks[x][y][z] = BLOCK_DIRT;
-                    } else if (y > terrainHeight - 3) {
-                        // 地表下3格是泥土
-                        m_blocks[x][y][z] = BLOCK_DIRT;
-                    } else {
-                        // 更深处是石头
-                        m_blocks[x][y][z] = BLOCK_STONE;
+                terrainHeight = (terrainHeight >= WORLD_HEIGHT) ? WORLD_HEIGHT - 1 : terrainHeight;
+                heights[x][z] = terrainHeight;
+                maxHeight = (terrainHeight > maxHeight) ? terrainHeight : maxHeight;
+            }
+        }
+
+        // 逐段生成：地表以上的段全是空气，不分配
+        for (int s = 0; s < SECTION_COUNT; s++) {
+            int baseY = s * CHUNK_SIZE;
+            if (baseY > maxHeight) {
+                m_sections[s].reset();
+                continue;
+            }
+
+            // 先生成到稠密数组，再一次性写入调色板存储
+            uint8_t blocks[CHUNK_SIZE][CHUNK_SIZE][CHUNK_SIZE];
+            for (int x = 0; x < CHUNK_SIZE; x++) {
+                for (int z = 0; z < CHUNK_SIZE; z++) {
+                    int terrainHeight = heights[x][z];
+                    for (int ly = 0; ly < CHUNK_SIZE; ly++) {
+                        int y = baseY + ly;
+                        if (y > terrainHeight) {
+                            // 地表以上是空气
+                            blocks[x][ly][z] = BLOCK_AIR;
+                        } else if (y == terrainHeight) {
+                            // 最顶层是泥土
+                            blocks[x][ly][z] = BLOCK_DIRT;
+                        } else if (y > terrainHeight - 3) {
+                            // 地表下3格是泥土
+                            blocks[x][ly][z] = BLOCK_DIRT;
+                        } else {
+                            // 更深处是石头
+                            blocks[x][ly][z] = BLOCK_STONE;
+                        }
                     }
                 }
             }
+            m_sections[s].reset(new ChunkSection());
+            m_sections[s]->blocks.assign(&blocks[0][0][0]);
         }
     }
     
-    // 检查某个位置是否是空气（用于面剔除）
-    bool isAir(int x, int y, int z) {
-        // 边界外视为空气，这样边缘的面会被渲染
-        if (x < 0 || x >= CHUNK_SIZE || 
-            y < 0 || y >= CHUNK_SIZE || 
-            z < 0 || z >= CHUNK_SIZE) {
-            return true;
+    // 生成一个段带一圈边界的方块和光照快照（用于面剔除、环境光遮蔽和面的亮度）
+    // 相邻区块未加载时边界视为露天的空气，这样世界边缘的面会被渲染
+    void gatherPadded(int sectionIndex, PaddedBlocks& out) const {
+        SectionSnapshot snapshot;
+        snapshotSection(sectionIndex, snapshot);
+        expandSnapshot(snapshot, out);
+    }
+
+    // 主线程：拍下一个段周围 3x3x3 个段的存储（只复制引用）
+    void snapshotSection(int sectionIndex, SectionSnapshot& out) const {
+        PROFILE_ZONE("Chunk::snapshotSection");
+        for (int dx = -1; dx <= 1; dx++) {
+            for (int dz = -1; dz <= 1; dz++) {
+                const Chunk* c = (dx == 0 && dz == 0) ? this : neighborAt(dx, dz);
+                if (c == nullptr) {
+                    continue;
+                }
+                for (int dy = -1; dy <= 1; dy++) {
+                    int s = sectionIndex + dy;
+                    if (s < 0) {
+                        out.light[dx + 1][0][dz + 1] = LightStorage(0);
+                        if (c == this) {
+                            out.blocks[1][0][1] = BlockStorage(BLOCK_STONE);
+                        }
+                        continue;
+                    }
+                    if (s >= SECTION_COUNT) {
+                        continue;
+                    }
+                    if (const ChunkSection* section = c->m_sections[s].get()) {
+                        out.blocks[dx + 1][dy + 1][dz + 1] = section->blocks;
+                    }
+                    out.light[dx + 1][dy + 1][dz + 1] = c->m_light[s];
+                }
+            }
         }
-        return m_blocks[x][y][z] == BLOCK_AIR;
+    }
+
+    // 可在任意线程：把快照展开成 18^3 的方块和光照
+    static void expandSnapshot(const SectionSnapshot& snapshot, PaddedBlocks& out) {
+        PROFILE_ZONE("Chunk::expandSnapshot");
+        const int N = CHUNK_SIZE;
+
+        // 段本身
+        const BlockStorage& center = snapshot.blocks[1][1][1];
+        if (center.isUniform()) {
+            uint16_t value = center.uniformValue();
+            for (int x = 0; x < N; x++) {
+                for (int y = 0; y < N; y++) {
+                    for (int z = 0; z < N; z++) {
+                        out.data[x + 1][y + 1][z + 1] = value;
+                    }
+                }
+            }
+        } else {
+            uint16_t dense[N][N][N];
+            center.copyTo(&dense[0][0][0]);
+            for (int x = 0; x < N; x++) {
+                for (int y = 0; y < N; y++) {
+                    std::memcpy(&out.data[x + 1][y + 1][1], dense[x][y], N * sizeof(uint16_t));
+                }
+            }
+        }
+        uint8_t denseLight[N][N][N];
+        snapshot.light[1][1][1].copyTo(&denseLight[0][0][0]);
+        for (int x = 0; x < N; x++) {
+            for (int y = 0; y < N; y++) {
+                std::memcpy(&out.light[x + 1][y + 1][1], denseLight[x][y], N);
+            }
+        }
+
+        // 上下两层取自同一列的相邻段
+        for (int x = 0; x < N; x++) {
+            for (int z = 0; z < N; z++) {
+                out.data[x + 1][0][z + 1] = snapshot.blocks[1][0][1].get(x, N - 1, z);
+                out.data[x + 1][N + 1][z + 1] = snapshot.blocks[1][2][1].get(x, 0, z);
+                out.light[x + 1][0][z + 1] = snapshot.light[1][0][1].get(x, N - 1, z);
+                out.light[x + 1][N + 1][z + 1] = snapshot.light[1][2][1].get(x, 0, z);
+            }
+        }
+
+        // 四周：相邻区块紧贴边界的那一层，上下各多一格（环境光遮蔽要读棱上的方块）；
+        // 四个角上的一列取自对角的区块
+        for (int dx = -1; dx <= 1; dx++) {
+            for (int dz = -1; dz <= 1; dz++) {
+                if (dx == 0 && dz == 0) {
+                    continue;
+                }
+                // 快照中的 x/z 范围，以及对应的相邻区块内坐标
+                int xBegin = (dx < 0) ? -1 : (dx > 0) ? N : 0;
+                int xEnd = (dx == 0) ? N : xBegin + 1;
+                int zBegin = (dz < 0) ? -1 : (dz > 0) ? N : 0;
+                int zEnd = (dz == 0) ? N : zBegin + 1;
+                for (int x = xBegin; x < xEnd; x++) {
+                    for (int z = zBegin; z < zEnd; z++) {
+                        int sourceX = x - dx * N;
+                        int sourceZ = z - dz * N;
+                        for (int y = -1; y <= N; y++) {
+                            int dy = (y < 0) ? 0 : (y < N) ? 1 : 2;
+                            int sourceY = y - (dy - 1) * N;
+                            out.data[x + 1][y + 1][z + 1] = snapshot.blocks[dx + 1][dy][dz + 1].get(sourceX, sourceY, sourceZ);
+                            out.light[x + 1][y + 1][z + 1] = snapshot.light[dx + 1][dy][dz + 1].get(sourceX, sourceY, sourceZ);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // 相邻区块（dx/dz 为 -1 ~ 1，不同时为 0）；对角的区块经过任一方向的相邻区块查找，未加载时返回 nullptr
+    Chunk* neighborAt(int dx, int dz) const {
+        int xDir = (dx < 0) ? NEIGHBOR_NEG_X : NEIGHBOR_POS_X;
+        int zDir = (dz < 0) ? NEIGHBOR_NEG_Z : NEIGHBOR_POS_Z;
+        if (dz == 0) {
+            return m_neighbors[xDir];
+        }
+        if (dx == 0) {
+            return m_neighbors[zDir];
+        }
+        Chunk* viaX = (m_neighbors[xDir] != nullptr) ? m_neighbors[xDir]->m_neighbors[zDir] : nullptr;
+        if (viaX != nullptr) {
+            return viaX;
+        }
+        return (m_neighbors[zDir] != nullptr) ? m_neighbors[zDir]->m_neighbors[xDir] : nullptr;
     }
     
     // 根据方块类型和面返回纹理索引（atlas中的偏移）
-    // Atlas布局(水平): dirt(0), stone(1), grass(2)
-    int getTextureIndex(uint8_t blockType, int face) {
+    // Atlas布局(水平): dirt(0), stone(1), grass(2), lamp(3)
+    static int getTextureIndex(uint16_t blockType, int face) {
         // face: 0=前, 1=后, 2=左, 3=右, 4=底, 5=顶
         switch (blockType) {
             case BLOCK_STONE:
@@ -115,137 +459,317 @@ public:
                 if (face == 5) return 2; // 顶面草
                 if (face == 4) return 0; // 底面泥土
                 return 0; // 侧面泥土（可后续添加草侧面贴图）
+            case BLOCK_LAMP:
+                return 3;
             default:
                 return 0;
         }
     }
 
-    // 添加一个面的顶点数据
-    void addFace(float x, float y, float z, int face, uint8_t blockType) {
-        // 每个面6个顶点（2个三角形），每个顶点5个float（位置3 + 纹理坐标2）
-        // face: 0=前, 1=后, 2=左, 3=右, 4=底, 5=顶
+    // 一个方块面四个角的环境光遮蔽（经典体素 AO），每个角 2 位，按角的顺序 (u0,v0) (u1,v0) (u1,v1) (u0,v1) 打包
+    // 每个角读面前方（法线方向）那一格在面内的两个侧邻和一个对角：两侧都实心时最暗（0），否则为 3 - 实心数
+    // 四个角共用前方那一格周围的 8 格，直接按快照中的步长读取
+    static int faceAO(const PaddedBlocks& blocks, int x, int y, int z, int face) {
+        static const int strides[3] = {PaddedBlocks::SIZE * PaddedBlocks::SIZE, PaddedBlocks::SIZE, 1};
+        const uint16_t* front = &blocks.data[x + 1 + FACE_NORMALS[face][0]]
+                                            [y + 1 + FACE_NORMALS[face][1]]
+                                            [z + 1 + FACE_NORMALS[face][2]];
+        const int du = strides[FACE_AXES[face][1]];
+        const int dv = strides[FACE_AXES[face][2]];
+        bool uNeg = front[-du] != BLOCK_AIR;
+        bool uPos = front[du] != BLOCK_AIR;
+        bool vNeg = front[-dv] != BLOCK_AIR;
+        bool vPos = front[dv] != BLOCK_AIR;
+        return cornerAO(uNeg, vNeg, front[-du - dv] != BLOCK_AIR)
+             | (cornerAO(uPos, vNeg, front[du - dv] != BLOCK_AIR) << 2)
+             | (cornerAO(uPos, vPos, front[du + dv] != BLOCK_AIR) << 4)
+             | (cornerAO(uNeg, vPos, front[-du + dv] != BLOCK_AIR) << 6);
+    }
+
+    static int cornerAO(bool side1, bool side2, bool corner) {
+        return (side1 && side2) ? 0 : 3 - (int)side1 - (int)side2 - (int)corner;
+    }
+
+    // 面的光照：面前方（法线方向）那一格的光照，整个面相同
+    static uint8_t faceLight(const PaddedBlocks& blocks, int x, int y, int z, int face) {
+        return blocks.getLight(x + FACE_NORMALS[face][0], y + FACE_NORMALS[face][1], z + FACE_NORMALS[face][2]);
+    }
+
+    // 添加一个方块面的顶点数据
+    static void addFace(std::vector<uint32_t>& out, const PaddedBlocks& blocks, int x, int y, int z, int face,
+                        uint16_t blockType) {
+        addQuad(out, x, y, z, face, getTextureIndex(blockType, face), 1, 1, faceAO(blocks, x, y, z, face),
+                faceLight(blocks, x, y, z, face));
+    }
 
-        // 计算atlas UV偏移
-        const int ATLAS_TILES = 3; // atlas中有3个贴图
-        int texIndex = getTextureIndex(blockType, face);
-        float tileWidth = 1.0f / ATLAS_TILES;
-        float uOffset = texIndex * tileWidth;
-
-        // 定义本地UV（0~1范围），之后映射到atlas
-        float localUV[6][6][2] = {
-            // 前面 (z+)
-            {{0,0},{1,0},{1,1},{1,1},{0,1},{0,0}},
-            // 后面 (z-)
-            {{0,0},{1,1},{1,0},{1,1},{0,0},{0,1}},
-            // 左面 (x-)
-            {{1,1},{0,1},{0,0},{0,0},{1,0},{1,1}},
-            // 右面 (x+)
-            {{0,1},{1,0},{1,1},{1,0},{0,1},{0,0}},
-            // 底面 (y-)
-            {{0,1},{1,1},{1,0},{1,0},{0,0},{0,1}},
-            // 顶面 (y+)
-            {{0,1},{1,0},{1,1},{1,0},{0,1},{0,0}}
-        };
-
-        float positions[6][6][3] = {
-            // 前面 (z+)
-            {{x,y,z+1},{x+1,y,z+1},{x+1,y+1,z+1},{x+1,y+1,z+1},{x,y+1,z+1},{x,y,z+1}},
-            // 后面 (z-)
-            {{x,y,z},{x+1,y+1,z},{x+1,y,z},{x+1,y+1,z},{x,y,z},{x,y+1,z}},
-            // 左面 (x-)
-            {{x,y+1,z+1},{x,y+1,z},{x,y,z},{x,y,z},{x,y,z+1},{x,y+1,z+1}},
-            // 右面 (x+)
-            {{x+1,y+1,z+1},{x+1,y,z},{x+1,y+1,z},{x+1,y,z},{x+1,y+1,z+1},{x+1,y,z+1}},
-            // 底面 (y-)
-            {{x,y,z},{x+1,y,z},{x+1,y,z+1},{x+1,y,z+1},{x,y,z+1},{x,y,z}},
-            // 顶面 (y+)
-            {{x,y+1,z},{x+1,y+1,z+1},{x+1,y+1,z},{x+1,y+1,z+1},{x,y+1,z},{x,y+1,z+1}}
-        };
+    // 打包一个顶点（布局见 VERTEX_* 常量）
+    static uint32_t packVertex(int x, int y, int z, int face, int texIndex, int ao, uint8_t light) {
+        return (uint32_t)x
+             | ((uint32_t)y << VERTEX_Y_SHIFT)
+             | ((uint32_t)z << VERTEX_Z_SHIFT)
+             | ((uint32_t)face << VERTEX_FACE_SHIFT)
+             | ((uint32_t)texIndex << VERTEX_TEX_SHIFT)
+             | ((uint32_t)ao << VERTEX_AO_SHIFT)
+             | ((uint32_t)light << VERTEX_LIGHT_SHIFT);
+    }
+
+    // 添加一个矩形面的顶点数据
+    // width/height 为面在其平面内 u/v 两个方向上的方块数（逐面网格时都是 1，贪婪网格合并后可以更大）：
+    // 前/后面沿 x/y，左/右面沿 z/y，底/顶面沿 x/z
+    // ao 为四个角的环境光遮蔽（faceAO 的打包格式），合并的面四个角相同，直接用于大矩形的四个角；
+    // light 为面的光照（faceLight）
+    static void addQuad(std::vector<uint32_t>& out, int x, int y, int z, int face, int texIndex,
+                        int width, int height, int ao, uint8_t light) {
+        // 每个面6个顶点（2个三角形），每个顶点一个打包的 uint32
+        // 纹理坐标不再存储：顶点着色器根据面方向和区块内位置推导（以方块为单位），
+        // 片段着色器用 fract 在贴图内平铺，合并后的大面仍然每格重复一次贴图
+        const int nAxis = FACE_AXES[face][0];
+        const int uAxis = FACE_AXES[face][1];
+        const int vAxis = FACE_AXES[face][2];
+        static const int cornerUV[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+
+        // 四个角按从面外看逆时针排列：u×v 与法线同向的面（前、左、底）按 0123，其余反过来
+        bool reversed = (face == 1 || face == 3 || face == 5);
+        uint32_t corners[4];
+        int cornerAO[4];
+        for (int i = 0; i < 4; i++) {
+            int c = reversed ? 3 - i : i;
+            int pos[3] = {x, y, z};
+            pos[nAxis] += (FACE_NORMALS[face][nAxis] > 0) ? 1 : 0;
+            pos[uAxis] += cornerUV[c][0] * width;
+            pos[vAxis] += cornerUV[c][1] * height;
+            cornerAO[i] = (ao >> (c * 2)) & 3;
+            corners[i] = packVertex(pos[0], pos[1], pos[2], face, texIndex, cornerAO[i], light);
+        }
 
+        // 沿较亮的那条对角线切分，四个角遮蔽不同时插值结果与面的朝向无关（避免各向异性的条纹）
+        static const int normalOrder[6] = {0, 1, 2, 2, 3, 0};
+        static const int flippedOrder[6] = {1, 2, 3, 3, 0, 1};
+        const int* order = (cornerAO[1] + cornerAO[3] > cornerAO[0] + cornerAO[2]) ? flippedOrder : normalOrder;
         for (int i = 0; i < 6; i++) {
-            // 位置
-            m_vertices.push_back(positions[face][i][0]);
-            m_vertices.push_back(positions[face][i][1]);
-            m_vertices.push_back(positions[face][i][2]);
-            // 纹理坐标（映射到atlas）
-            float u = uOffset + localUV[face][i][0] * tileWidth;
-            float v = localUV[face][i][1];
-            m_vertices.push_back(u);
-            m_vertices.push_back(v);
+            out.push_back(corners[order[i]]);
         }
     }
-    
-    // 【核心】构建网格
-    void updateMesh() {
-        m_vertices.clear();
-        
+
+    // 逐面网格：每个暴露的方块面生成一个四边形
+    static void buildMeshNaive(const PaddedBlocks& blocks, std::vector<uint32_t>& out) {
         for (int x = 0; x < CHUNK_SIZE; x++) {
             for (int y = 0; y < CHUNK_SIZE; y++) {
                 for (int z = 0; z < CHUNK_SIZE; z++) {
+                    uint16_t blockType = blocks.get(x, y, z);
+
                     // 如果当前方块是空气，跳过
-                    if (m_blocks[x][y][z] == BLOCK_AIR) {
+                    if (blockType == BLOCK_AIR) {
                         continue;
                     }
                     
-                    uint8_t blockType = m_blocks[x][y][z];
-                    
                     // 检查每个面是否需要渲染（相邻方块是否为空气）
                     // 前面 (z+)
-                    if (isAir(x, y, z + 1)) {
-                        addFace((float)x, (float)y, (float)z, 0, blockType);
+                    if (blocks.isAir(x, y, z + 1)) {
+                        addFace(out, blocks, x, y, z, 0, blockType);
                     }
                     // 后面 (z-)
-                    if (isAir(x, y, z - 1)) {
-                        addFace((float)x, (float)y, (float)z, 1, blockType);
+                    if (blocks.isAir(x, y, z - 1)) {
+                        addFace(out, blocks, x, y, z, 1, blockType);
                     }
                     // 左面 (x-)
-                    if (isAir(x - 1, y, z)) {
-                        addFace((float)x, (float)y, (float)z, 2, blockType);
+                    if (blocks.isAir(x - 1, y, z)) {
+                        addFace(out, blocks, x, y, z, 2, blockType);
                     }
                     // 右面 (x+)
-                    if (isAir(x + 1, y, z)) {
-                        addFace((float)x, (float)y, (float)z, 3, blockType);
+                    if (blocks.isAir(x + 1, y, z)) {
+                        addFace(out, blocks, x, y, z, 3, blockType);
                     }
                     // 底面 (y-)
-                    if (isAir(x, y - 1, z)) {
-                        addFace((float)x, (float)y, (float)z, 4, blockType);
+                    if (blocks.isAir(x, y - 1, z)) {
+                        addFace(out, blocks, x, y, z, 4, blockType);
                     }
                     // 顶面 (y+)
-                    if (isAir(x, y + 1, z)) {
-                        addFace((float)x, (float)y, (float)z, 5, blockType);
+                    if (blocks.isAir(x, y + 1, z)) {
+                        addFace(out, blocks, x, y, z, 5, blockType);
+                    }
+                }
+            }
+        }
+    }
+
+    // 贪婪网格：逐层扫描每个方向，把同一平面内贴图相同的相邻面合并成尽可能大的矩形
+    static void buildMeshGreedy(const PaddedBlocks& blocks, std::vector<uint32_t>& out) {
+        // mask[u][v]：0 表示该位置没有面，否则为 (贴图索引 + 1) | (四个角的环境光遮蔽 << 8) | (光照 << 16)
+        // 贴图、遮蔽和光照都相同的面才能合并，合并后的矩形与其中每个面相同
+        int mask[CHUNK_SIZE][CHUNK_SIZE];
+
+        for (int face = 0; face < 6; face++) {
+            const int nAxis = FACE_AXES[face][0];
+            const int uAxis = FACE_AXES[face][1];
+            const int vAxis = FACE_AXES[face][2];
+
+            for (int d = 0; d < CHUNK_SIZE; d++) {
+                // 1. 生成这一层的面掩码
+                for (int u = 0; u < CHUNK_SIZE; u++) {
+                    for (int v = 0; v < CHUNK_SIZE; v++) {
+                        int pos[3];
+                        pos[nAxis] = d;
+                        pos[uAxis] = u;
+                        pos[vAxis] = v;
+                        uint16_t blockType = blocks.get(pos[0], pos[1], pos[2]);
+                        bool visible = blockType != BLOCK_AIR &&
+                            blocks.isAir(pos[0] + FACE_NORMALS[face][0],
+                                  pos[1] + FACE_NORMALS[face][1],
+                                  pos[2] + FACE_NORMALS[face][2]);
+                        mask[u][v] = 0;
+                        if (visible) {
+                            mask[u][v] = (getTextureIndex(blockType, face) + 1) |
+                                         (faceAO(blocks, pos[0], pos[1], pos[2], face) << 8) |
+                                         (faceLight(blocks, pos[0], pos[1], pos[2], face) << 16);
+                        }
+                    }
+                }
+
+                // 2. 在掩码上贪婪地取最大矩形：先沿 u 扩展宽度，再沿 v 扩展高度
+                for (int v = 0; v < CHUNK_SIZE; v++) {
+                    for (int u = 0; u < CHUNK_SIZE; ) {
+                        int tile = mask[u][v];
+                        if (tile == 0) {
+                            u++;
+                            continue;
+                        }
+
+                        int width = 1;
+                        while (u + width < CHUNK_SIZE && mask[u + width][v] == tile) {
+                            width++;
+                        }
+
+                        int height = 1;
+                        bool canGrow = true;
+                        while (v + height < CHUNK_SIZE && canGrow) {
+                            for (int k = 0; k < width; k++) {
+                                if (mask[u + k][v + height] != tile) {
+                                    canGrow = false;
+                                    break;
+                                }
+                            }
+                            if (canGrow) {
+                                height++;
+                            }
+                        }
+
+                        int pos[3];
+                        pos[nAxis] = d;
+                        pos[uAxis] = u;
+                        pos[vAxis] = v;
+                        addQuad(out, pos[0], pos[1], pos[2], face, (tile & 0xFF) - 1, width, height,
+                                (tile >> 8) & 0xFF, (uint8_t)(tile >> 16));
+
+                        // 清除已合并的区域
+                        for (int dv = 0; dv < height; dv++) {
+                            for (int du = 0; du < width; du++) {
+                                mask[u + du][v + dv] = 0;
+                            }
+                        }
+                        u += width;
                     }
                 }
             }
         }
-        
-        // 创建或更新 VAO/VBO
-        if (VAO == 0) {
-            glGenVertexArrays(1, &VAO);
-            glGenBuffers(1, &VBO);
-        }
-        
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(float), 
-                     m_vertices.data(), GL_STATIC_DRAW);
-        
-        // 位置属性 (3 floats)
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-        // 纹理坐标属性 (2 floats)
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-        glEnableVertexAttribArray(1);
-        
-        glBindVertexArray(0);
+    }
+
+    // 根据方块快照生成顶点数据：纯 CPU 计算，不访问区块本身，可以在工作线程上运行
+    static void buildVertices(const PaddedBlocks& blocks, MeshMode mode, std::vector<uint32_t>& out) {
+        PROFILE_ZONE("Chunk::buildVertices");
+        out.clear();
+        if (blocks.isEnclosed()) {
+            return;
+        }
+        if (mode == MESH_GREEDY) {
+            buildMeshGreedy(blocks, out);
+        } else {
+            buildMeshNaive(blocks, out);
+        }
+    }
+
+    // 只在 CPU 上生成一个段的顶点数据（不调用任何 OpenGL 函数）
+    void buildMesh(int sectionIndex) {
+        ChunkSection* section = m_sections[sectionIndex].get();
+        if (section == nullptr) {
+            return;
+        }
+        PaddedBlocks blocks;
+        gatherPadded(sectionIndex, blocks);
+        buildVertices(blocks, s_meshMode, section->vertices);
+        section->meshDirty = false;
+    }
+
+    // 段的世界坐标原点
+    glm::vec3 sectionOrigin(int sectionIndex) const {
+        return glm::vec3(m_chunkX * CHUNK_SIZE, sectionIndex * CHUNK_SIZE, m_chunkZ * CHUNK_SIZE);
+    }
+
+    // 把一个段的顶点上传到共享顶点缓冲（必须在 OpenGL 线程调用），然后释放 CPU 端的顶点
+    void uploadMesh(MeshArena& arena, int sectionIndex) {
+        PROFILE_ZONE("Chunk::uploadMesh");
+        ChunkSection* section = m_sections[sectionIndex].get();
+        if (section != nullptr) {
+            arena.upload(section->mesh, section->vertices, sectionOrigin(sectionIndex));
+            std::vector<uint32_t>().swap(section->vertices);
+        }
+    }
+
+    // 归还所有段在共享顶点缓冲中的空间（卸载区块前调用）
+    void releaseMesh(MeshArena& arena) {
+        for (int s = 0; s < SECTION_COUNT; s++) {
+            if (m_sections[s] != nullptr) {
+                arena.release(m_sections[s]->mesh);
+            }
+        }
+    }
+
+    // 作废所有还在后台进行的网格任务（版本号前移，完成后的结果会被丢弃，不再上传）
+    void cancelPendingMeshes() {
+        for (int s = 0; s < SECTION_COUNT; s++) {
+            if (m_sections[s] != nullptr) {
+                m_sections[s]->meshVersion++;
+            }
+        }
+    }
+
+    // 【核心】构建所有段的网格（串行：生成顶点后立即上传）
+    void updateMesh(MeshArena& arena) {
+        for (int s = 0; s < SECTION_COUNT; s++) {
+            buildMesh(s);
+            uploadMesh(arena, s);
+        }
+    }
+
+    // 所有段的顶点数（每个顶点一个 uint32）：已上传的段按 GPU 上的网格计，还没上传的按 CPU 端的顶点计
+    size_t vertexCount() const {
+        size_t count = 0;
+        for (int s = 0; s < SECTION_COUNT; s++) {
+            const ChunkSection* section = m_sections[s].get();
+            if (section != nullptr) {
+                count += section->vertices.empty() ? (size_t)section->mesh.vertexCount : section->vertices.size();
+            }
+        }
+        return count;
+    }
+
+    // CPU 端顶点占用的内存（含 vector 的预留容量）
+    size_t vertexBytes() const {
+        size_t bytes = 0;
+        for (int s = 0; s < SECTION_COUNT; s++) {
+            if (m_sections[s] != nullptr) {
+                bytes += m_sections[s]->vertices.capacity() * sizeof(uint32_t);
+            }
+        }
+        return bytes;
     }
     
-    // 绘制函数
-    void render() {
-        if (m_vertices.empty()) return;
-        
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLES, 0, m_vertices.size() / 5);
-        glBindVertexArray(0);
+    // 绘制函数：把一个段加入本帧的合并绘制列表，由 MeshArena::draw 统一提交
+    void render(MeshArena& arena, int sectionIndex) {
+        ChunkSection* section = m_sections[sectionIndex].get();
+        if (section != nullptr) {
+            arena.addDraw(section->mesh);
+        }
     }
 };
 
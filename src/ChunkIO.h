@@ -0,0 +1,354 @@
+#ifndef CHUNK_IO_H
+#define CHUNK_IO_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Chunk.h"
+#include "ChunkMap.h"
+#include "Profiler.h"
+#include "WorldStorage.h"
+
+// 存档 I/O 线程：主线程只提交请求，读写区域文件都在这个线程上进行，不阻塞渲染循环
+// - 保存：提交时拍下方块快照（只复制调色板和打包数据），编码和写入在 I/O 线程上做；
+//   同一个区块还没写盘时再次保存只保留最新的快照
+// - 每次取走队列中的全部请求作为一批：先处理读取（玩家在等），再按区域文件排序写入，
+//   整批写完后每个区域文件只 fsync 一次
+// - 读取：只读出存档数据（READ_MMAP 时只是映射中的位置，不复制），不解码（解码和生成地形一样交给流水线的工作线程），
+//   结果放进完成队列，由主线程在时间预算内取走；还在等待写盘的区块直接返回队列中的快照的编码
+class ChunkIO {
+public:
+    // 读取结果：found 为 false 表示没有存档（需要生成地形）
+    struct Loaded {
+        int chunkX = 0;
+        int chunkZ = 0;
+        bool found = false;
+        ChunkData data;
+    };
+
+    // 统计（延迟为从提交请求到读取完成 / 写入落盘，单位毫秒；P50/P99 取自对数分桶直方图，相对误差不超过约 6%，最大值精确）
+    struct Stats {
+        size_t queueDepth = 0;         // 当前等待中的请求数
+        size_t maxQueueDepth = 0;
+        size_t loads = 0;
+        size_t saves = 0;              // 实际写入（或删除）的区块数
+        size_t coalescedSaves = 0;     // 被同一区块更新的快照覆盖、没有单独写入的保存请求
+        size_t batches = 0;
+        size_t syncs = 0;              // fsync 次数
+        double loadP50 = 0.0, loadP99 = 0.0, loadMax = 0.0;
+        double saveP50 = 0.0, saveP99 = 0.0, saveMax = 0.0;
+    };
+
+    explicit ChunkIO(WorldStorage& storage)
+        : m_storage(storage), m_stop(false), m_busy(false) {
+        m_thread = std::thread([this]() { threadLoop(); });
+    }
+
+    // 处理完所有已提交的请求后退出
+    ~ChunkIO() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_one();
+        m_thread.join();
+    }
+
+    ChunkIO(const ChunkIO&) = delete;
+    ChunkIO& operator=(const ChunkIO&) = delete;
+
+    WorldStorage& storage() { return m_storage; }
+
+    void requestLoad(int chunkX, int chunkZ) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_loads.push_back({chunkX, chunkZ, Clock::now()});
+            updateQueueDepth();
+        }
+        m_wake.notify_one();
+    }
+
+    // 保存区块当前的方块（调用线程上复制快照，之后区块可以立即释放）
+    void requestSave(Chunk& chunk) {
+        std::unique_ptr<Chunk> snapshot(new Chunk());
+        snapshot->m_chunkX = chunk.m_chunkX;
+        snapshot->m_chunkZ = chunk.m_chunkZ;
+        snapshot->m_hasEdits = chunk.m_hasEdits;
+        for (int s = 0; s < Chunk::SECTION_COUNT; s++) {
+            const ChunkSection* section = chunk.getSection(s);
+            if (section != nullptr) {
+                snapshot->m_sections[s].reset(new ChunkSection());
+                snapshot->m_sections[s]->blocks = section->blocks;
+            }
+        }
+        chunk.m_needsSave = false;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            SaveRequest& request = m_saves[ChunkMap::packKey(chunk.m_chunkX, chunk.m_chunkZ)];
+            if (request.snapshot != nullptr) {
+                m_stats.coalescedSaves++;   // 保留最早的提交时间，延迟按第一次请求计算
+            } else {
+                request.queued = Clock::now();
+            }
+            request.snapshot = std::move(snapshot);
+            updateQueueDepth();
+        }
+        m_wake.notify_one();
+    }
+
+    // 主线程调用：取走读取结果交给 onLoaded(Loaded&)
+    // budgetSeconds < 0 表示处理全部结果，否则超出时间预算后停止；返回处理的结果数
+    template <typename OnLoaded>
+    size_t processCompleted(OnLoaded onLoaded, double budgetSeconds = -1.0) {
+        PROFILE_ZONE("ChunkIO::processCompleted");
+        auto start = Clock::now();
+        size_t processed = 0;
+        while (true) {
+            Loaded done;
+            {
+                std::lock_guard<std::mutex> lock(m_completedMutex);
+                if (m_completed.empty()) {
+                    break;
+                }
+                done = std::move(m_completed.front());
+                m_completed.pop_front();
+            }
+            onLoaded(done);
+            processed++;
+            if (budgetSeconds >= 0.0) {
+                std::chrono::duration<double> elapsed = Clock::now() - start;
+                if (elapsed.count() >= budgetSeconds) {
+                    break;
+                }
+            }
+        }
+        return processed;
+    }
+
+    // 等待所有已提交的请求处理完（写入已落盘，读取结果在完成队列中）
+    void waitIdle() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_idle.wait(lock, [this]() { return m_loads.empty() && m_saves.empty() && !m_busy; });
+    }
+
+    // 丢弃还没取走的读取结果（退出时）
+    void discardCompleted() {
+        std::lock_guard<std::mutex> lock(m_completedMutex);
+        m_completed.clear();
+    }
+
+    Stats stats() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Stats result = m_stats;
+        result.queueDepth = m_loads.size() + m_saves.size();
+        m_loadLatencies.percentiles(result.loadP50, result.loadP99, result.loadMax);
+        m_saveLatencies.percentiles(result.saveP50, result.saveP99, result.saveMax);
+        return result;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct LoadRequest {
+        int chunkX, chunkZ;
+        Clock::time_point queued;
+    };
+
+    struct SaveRequest {
+        std::unique_ptr<Chunk> snapshot;
+        Clock::time_point queued;
+    };
+
+    static double millisecondsSince(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // 延迟直方图：按 2 的幂分段（1 微秒 ~ 约 134 秒），每段再均分 8 个桶；内存固定，长时间运行也不增长
+    class LatencyHistogram {
+    public:
+        static const int SUB_BUCKETS = 8;
+        static const int OCTAVES = 28;
+        static const int BUCKETS = 1 + OCTAVES * SUB_BUCKETS;   // 第 0 个桶为不到 1 微秒
+
+        LatencyHistogram() : m_total(0), m_max(0.0) {
+            std::fill(m_counts, m_counts + BUCKETS, 0);
+        }
+
+        void add(double milliseconds) {
+            m_counts[bucketOf(milliseconds * 1000.0)]++;
+            m_total++;
+            m_max = std::max(m_max, milliseconds);
+        }
+
+        void percentiles(double& p50, double& p99, double& max) const {
+            if (m_total == 0) {
+                return;
+            }
+            p50 = percentile(m_total / 2);
+            p99 = percentile(m_total * 99 / 100);
+            max = m_max;
+        }
+
+    private:
+        static int bucketOf(double microseconds) {
+            if (!(microseconds >= 1.0)) {
+                return 0;
+            }
+            int exponent;
+            double mantissa = std::frexp(microseconds, &exponent);   // microseconds = mantissa * 2^exponent，mantissa 在 [0.5, 1)
+            int octave = exponent - 1;
+            if (octave >= OCTAVES) {
+                return BUCKETS - 1;
+            }
+            int sub = std::min(SUB_BUCKETS - 1, (int)((mantissa * 2.0 - 1.0) * SUB_BUCKETS));
+            return 1 + octave * SUB_BUCKETS + sub;
+        }
+
+        // 桶的中点（毫秒）
+        static double bucketValue(int bucket) {
+            if (bucket == 0) {
+                return 0.0005;
+            }
+            int octave = (bucket - 1) / SUB_BUCKETS;
+            int sub = (bucket - 1) % SUB_BUCKETS;
+            return std::ldexp(1.0 + (sub + 0.5) / SUB_BUCKETS, octave) / 1000.0;
+        }
+
+        // 排序后第 rank 个（从 0 开始）样本所在桶的值，不超过最大值
+        double percentile(uint64_t rank) const {
+            uint64_t seen = 0;
+            for (int b = 0; b < BUCKETS; b++) {
+                seen += m_counts[b];
+                if (seen > rank) {
+                    return std::min(bucketValue(b), m_max);
+                }
+            }
+            return m_max;
+        }
+
+        uint64_t m_counts[BUCKETS];
+        uint64_t m_total;
+        double m_max;
+    };
+
+    // 调用方持有 m_mutex
+    void updateQueueDepth() {
+        m_stats.maxQueueDepth = std::max(m_stats.maxQueueDepth, m_loads.size() + m_saves.size());
+    }
+
+    void threadLoop() {
+        Profiler::setThreadName("chunk io");
+        std::vector<LoadRequest> loads;
+        std::unordered_map<uint64_t, SaveRequest> saves;
+        std::vector<std::pair<uint64_t, SaveRequest*>> order;
+        std::vector<double> loadLatencies;
+        std::vector<double> saveLatencies;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [this]() { return m_stop || !m_loads.empty() || !m_saves.empty(); });
+                if (m_loads.empty() && m_saves.empty()) {
+                    return;   // m_stop 且没有剩余请求
+                }
+                loads.swap(m_loads);
+                saves.swap(m_saves);
+                m_busy = true;
+            }
+            PROFILE_ZONE("ChunkIO batch");
+
+            // 先读取：还没写盘的区块以队列中的快照为准
+            loadLatencies.clear();
+            for (const LoadRequest& request : loads) {
+                Loaded done;
+                done.chunkX = request.chunkX;
+                done.chunkZ = request.chunkZ;
+                auto pending = saves.find(ChunkMap::packKey(request.chunkX, request.chunkZ));
+                if (pending != saves.end()) {
+                    done.found = m_storage.encodeForSave(*pending->second.snapshot, done.data.buffer);
+                } else {
+                    done.found = m_storage.readChunkData(request.chunkX, request.chunkZ, done.data);
+                }
+                {
+                    std::lock_guard<std::mutex> lock(m_completedMutex);
+                    m_completed.push_back(std::move(done));
+                }
+                loadLatencies.push_back(millisecondsSince(request.queued));
+            }
+
+            // 再按区域文件（同一区域内按区块）排序写入，整批只在最后 fsync
+            order.clear();
+            for (auto& entry : saves) {
+                order.push_back({entry.first, &entry.second});
+            }
+            std::sort(order.begin(), order.end(), [](const std::pair<uint64_t, SaveRequest*>& a,
+                                                     const std::pair<uint64_t, SaveRequest*>& b) {
+                const Chunk& ca = *a.second->snapshot;
+                const Chunk& cb = *b.second->snapshot;
+                int ra[2] = {WorldStorage::regionCoord(ca.m_chunkX), WorldStorage::regionCoord(ca.m_chunkZ)};
+                int rb[2] = {WorldStorage::regionCoord(cb.m_chunkX), WorldStorage::regionCoord(cb.m_chunkZ)};
+                if (ra[0] != rb[0] || ra[1] != rb[1]) {
+                    return (ra[0] != rb[0]) ? ra[0] < rb[0] : ra[1] < rb[1];
+                }
+                return a.first < b.first;
+            });
+            for (auto& entry : order) {
+                m_storage.saveChunk(*entry.second->snapshot, false);
+            }
+            int syncs = order.empty() ? 0 : m_storage.syncAll();
+            saveLatencies.clear();
+            for (auto& entry : order) {
+                saveLatencies.push_back(millisecondsSince(entry.second->queued));
+            }
+
+            loads.clear();
+            saves.clear();
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stats.loads += loadLatencies.size();
+                m_stats.saves += saveLatencies.size();
+                m_stats.batches++;
+                m_stats.syncs += syncs;
+                for (double ms : loadLatencies) {
+                    m_loadLatencies.add(ms);
+                }
+                for (double ms : saveLatencies) {
+                    m_saveLatencies.add(ms);
+                }
+                m_busy = false;
+                if (m_loads.empty() && m_saves.empty()) {
+                    m_idle.notify_all();
+                }
+            }
+        }
+    }
+
+    WorldStorage& m_storage;
+
+    std::mutex m_mutex;                                  // 保护请求队列和统计
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    std::vector<LoadRequest> m_loads;
+    std::unordered_map<uint64_t, SaveRequest> m_saves;   // 按区块坐标合并（ChunkMap::packKey）
+    bool m_stop;
+    bool m_busy;                                         // I/O 线程正在处理一批请求
+    Stats m_stats;
+    LatencyHistogram m_loadLatencies;
+    LatencyHistogram m_saveLatencies;
+
+    std::mutex m_completedMutex;
+    std::deque<Loaded> m_completed;
+
+    // 线程最后声明：启动时其他成员都已初始化
+    std::thread m_thread;
+};
+
+#endif
@@ -0,0 +1,324 @@
+#ifndef CHUNK_MAP_H
+#define CHUNK_MAP_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "Chunk.h"
+
+// 区块注册表：开放寻址哈希表（线性探测），键为打包成 64 位的区块坐标
+// 附带一个"上次命中"缓存：碰撞检测等空间连续的查询大多落在同一个区块上，
+// 命中缓存时无需计算哈希和探测
+// 插入/删除时同时维护区块的相邻指针；插入时把受影响的相邻区块标记为需要重建网格，
+// 删除时不标记：相邻区块保留按原来的相邻区块生成的网格（见 unlinkNeighbors）
+class ChunkMap {
+public:
+    ChunkMap() : m_size(0), m_lastKey(0), m_lastChunk(nullptr) {
+        m_slots.resize(MIN_CAPACITY);
+    }
+
+    // 把区块坐标打包成 64 位键：高 32 位为 x，低 32 位为 z
+    static uint64_t packKey(int chunkX, int chunkZ) {
+        return ((uint64_t)(uint32_t)chunkX << 32) | (uint64_t)(uint32_t)chunkZ;
+    }
+
+    static int keyX(uint64_t key) { return (int)(uint32_t)(key >> 32); }
+    static int keyZ(uint64_t key) { return (int)(uint32_t)key; }
+
+    // 查找区块，不存在时返回 nullptr
+    Chunk* find(int chunkX, int chunkZ) const {
+        uint64_t key = packKey(chunkX, chunkZ);
+        if (m_lastChunk != nullptr && key == m_lastKey) {
+            return m_lastChunk;
+        }
+
+        size_t mask = m_slots.size() - 1;
+        for (size_t i = hash(key) & mask; ; i = (i + 1) & mask) {
+            const Slot& slot = m_slots[i];
+            if (slot.chunk == nullptr) {
+                return nullptr;
+            }
+            if (slot.key == key) {
+                m_lastKey = key;
+                m_lastChunk = slot.chunk;
+                return slot.chunk;
+            }
+        }
+    }
+
+    bool contains(int chunkX, int chunkZ) const {
+        return find(chunkX, chunkZ) != nullptr;
+    }
+
+    // 方块坐标所在的区块坐标（向下取整）
+    static int blockToChunk(int block) {
+        return (block >= 0) ? block / Chunk::CHUNK_SIZE : (block - Chunk::CHUNK_SIZE + 1) / Chunk::CHUNK_SIZE;
+    }
+
+    // 世界坐标的方块；区块未加载时为空气
+    uint16_t getBlock(int worldX, int y, int worldZ) const {
+        int chunkX = blockToChunk(worldX);
+        int chunkZ = blockToChunk(worldZ);
+        const Chunk* chunk = find(chunkX, chunkZ);
+        if (chunk == nullptr) {
+            return BLOCK_AIR;
+        }
+        return chunk->getBlock(worldX - chunkX * Chunk::CHUNK_SIZE, y, worldZ - chunkZ * Chunk::CHUNK_SIZE);
+    }
+
+    // 修改世界坐标的方块，只把受影响的段标记为需要重建网格：方块周围 3x3x3 格所在的段
+    // （面剔除只看六个方向，环境光遮蔽还要看棱和角）：方块所在的段，位于段的上下边界时还有上/下方的段，
+    // 位于区块边界时还有相邻区块（在区块的角上还有对角的区块）的这些段
+    // 区块未加载、超出世界高度或方块没有变化时返回 false
+    // touched 不为空时追加被标记的区块（方块所在区块在前）
+    bool setBlock(int worldX, int y, int worldZ, uint16_t blockType, std::vector<Chunk*>* touched = nullptr) {
+        const int N = Chunk::CHUNK_SIZE;
+        int chunkX = blockToChunk(worldX);
+        int chunkZ = blockToChunk(worldZ);
+        Chunk* chunk = find(chunkX, chunkZ);
+        if (chunk == nullptr || y < 0 || y >= Chunk::WORLD_HEIGHT) {
+            return false;
+        }
+        int localX = worldX - chunkX * N;
+        int localZ = worldZ - chunkZ * N;
+        if (chunk->getBlock(localX, y, localZ) == blockType) {
+            return false;
+        }
+        chunk->setBlock(localX, y, localZ, blockType);
+        chunk->m_needsSave = true;
+        chunk->m_hasEdits = true;
+
+        int section = y / N;
+        int localY = y % N;
+        int firstSection = (localY == 0) ? section - 1 : section;
+        int lastSection = (localY == N - 1) ? section + 1 : section;
+        int firstDx = (localX == 0) ? -1 : 0;
+        int lastDx = (localX == N - 1) ? 1 : 0;
+        int firstDz = (localZ == 0) ? -1 : 0;
+        int lastDz = (localZ == N - 1) ? 1 : 0;
+        for (int s = firstSection; s <= lastSection; s++) {
+            chunk->markSectionDirty(s);
+        }
+        if (touched != nullptr) {
+            touched->push_back(chunk);
+        }
+
+        // 区块边界上的方块还会影响相邻区块的边界面和遮蔽
+        for (int dx = firstDx; dx <= lastDx; dx++) {
+            for (int dz = firstDz; dz <= lastDz; dz++) {
+                Chunk* neighbor = (dx == 0 && dz == 0) ? nullptr : chunk->neighborAt(dx, dz);
+                if (neighbor == nullptr) {
+                    continue;
+                }
+                for (int s = firstSection; s <= lastSection; s++) {
+                    neighbor->markSectionDirty(s);
+                }
+                if (touched != nullptr) {
+                    touched->push_back(neighbor);
+                }
+            }
+        }
+        return true;
+    }
+
+    // 插入区块；坐标已存在时先断开旧区块的相邻关系再覆盖（不负责释放旧区块）
+    void insert(int chunkX, int chunkZ, Chunk* chunk) {
+        if (chunk == nullptr) {
+            erase(chunkX, chunkZ);
+            return;
+        }
+        Chunk* old = find(chunkX, chunkZ);
+        if (old == chunk) {
+            return;
+        }
+        if (old != nullptr) {
+            unlinkNeighbors(old);
+        }
+        insertSlot(chunkX, chunkZ, chunk);
+        linkNeighbors(chunkX, chunkZ, chunk);
+    }
+
+    // 删除区块，返回是否存在（不负责释放区块）
+    bool erase(int chunkX, int chunkZ) {
+        Chunk* chunk = find(chunkX, chunkZ);
+        if (chunk == nullptr) {
+            return false;
+        }
+        unlinkNeighbors(chunk);
+        return eraseSlot(chunkX, chunkZ);
+    }
+
+    // 删除所有区块（不负责释放区块）；区块之间的相邻指针全部清空，释放后不会留下悬空指针
+    void clear() {
+        for (const Slot& slot : m_slots) {
+            if (slot.chunk != nullptr) {
+                for (int dir = 0; dir < 4; dir++) {
+                    slot.chunk->m_neighbors[dir] = nullptr;
+                }
+            }
+        }
+        m_slots.assign(MIN_CAPACITY, Slot());
+        m_size = 0;
+        m_lastChunk = nullptr;
+    }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    // 遍历所有区块：func(chunkX, chunkZ, Chunk*)
+    // 遍历过程中不要插入或删除
+    template <typename Func>
+    void forEach(Func func) const {
+        for (const Slot& slot : m_slots) {
+            if (slot.chunk != nullptr) {
+                func(keyX(slot.key), keyZ(slot.key), slot.chunk);
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        uint64_t key = 0;
+        Chunk* chunk = nullptr;   // nullptr 表示空槽
+    };
+
+    static constexpr size_t MIN_CAPACITY = 64;   // 必须是 2 的幂
+
+    // 与 ChunkNeighbor 顺序一致的坐标偏移
+    static constexpr int NEIGHBOR_OFFSETS[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+
+    // 与四个相邻区块互相连接；已有的相邻区块边界面可能被新区块遮住，需要重建网格
+    void linkNeighbors(int chunkX, int chunkZ, Chunk* chunk) {
+        for (int dir = 0; dir < 4; dir++) {
+            Chunk* neighbor = find(chunkX + NEIGHBOR_OFFSETS[dir][0], chunkZ + NEIGHBOR_OFFSETS[dir][1]);
+            chunk->m_neighbors[dir] = neighbor;
+            if (neighbor != nullptr) {
+                neighbor->m_neighbors[dir ^ 1] = chunk;
+                neighbor->markAllMeshesDirty();
+            }
+        }
+        markDiagonalsDirty(chunk);
+        chunk->markAllMeshesDirty();
+    }
+
+    // 断开相邻关系，不标记相邻区块重建网格：缺少相邻区块的区块不会生成网格（ChunkStreamer 的 hasAllNeighbors），
+    // 标记了也只会一直留着脏标记；它们保留原来的网格，相邻区块重新加载时 linkNeighbors 再标记重建
+    void unlinkNeighbors(Chunk* chunk) {
+        for (int dir = 0; dir < 4; dir++) {
+            Chunk* neighbor = chunk->m_neighbors[dir];
+            if (neighbor != nullptr) {
+                neighbor->m_neighbors[dir ^ 1] = nullptr;
+                chunk->m_neighbors[dir] = nullptr;
+            }
+        }
+    }
+
+    // 对角的区块只有角上那一列的环境光遮蔽会变，但那一列跨越所有段，整个区块重建
+    void markDiagonalsDirty(const Chunk* chunk) {
+        for (int dx = -1; dx <= 1; dx += 2) {
+            for (int dz = -1; dz <= 1; dz += 2) {
+                if (Chunk* diagonal = chunk->neighborAt(dx, dz)) {
+                    diagonal->markAllMeshesDirty();
+                }
+            }
+        }
+    }
+
+    void insertSlot(int chunkX, int chunkZ, Chunk* chunk) {
+        // 负载因子保持在 1/2 以下，探测链足够短
+        if ((m_size + 1) * 2 > m_slots.size()) {
+            rehash(m_slots.size() * 2);
+        }
+
+        uint64_t key = packKey(chunkX, chunkZ);
+        size_t mask = m_slots.size() - 1;
+        for (size_t i = hash(key) & mask; ; i = (i + 1) & mask) {
+            Slot& slot = m_slots[i];
+            if (slot.chunk == nullptr) {
+                slot.key = key;
+                slot.chunk = chunk;
+                m_size++;
+                break;
+            }
+            if (slot.key == key) {
+                slot.chunk = chunk;
+                break;
+            }
+        }
+
+        if (m_lastChunk != nullptr && key == m_lastKey) {
+            m_lastChunk = chunk;
+        }
+    }
+
+    bool eraseSlot(int chunkX, int chunkZ) {
+        uint64_t key = packKey(chunkX, chunkZ);
+        size_t mask = m_slots.size() - 1;
+        size_t i = hash(key) & mask;
+        while (true) {
+            if (m_slots[i].chunk == nullptr) {
+                return false;
+            }
+            if (m_slots[i].key == key) {
+                break;
+            }
+            i = (i + 1) & mask;
+        }
+
+        if (key == m_lastKey) {
+            m_lastChunk = nullptr;
+        }
+
+        // 向后移位删除：把后续探测链上的元素前移填补空位，不需要墓碑标记
+        size_t hole = i;
+        for (size_t j = (i + 1) & mask; m_slots[j].chunk != nullptr; j = (j + 1) & mask) {
+            size_t home = hash(m_slots[j].key) & mask;
+            // 元素 j 的理想位置不在 (hole, j] 区间内时，才能移动到 hole
+            bool canMove = (hole <= j) ? (home <= hole || home > j)
+                                       : (home <= hole && home > j);
+            if (canMove) {
+                m_slots[hole] = m_slots[j];
+                hole = j;
+            }
+        }
+        m_slots[hole] = Slot();
+        m_size--;
+        return true;
+    }
+
+    // splitmix64 的混合函数：相邻坐标的键也能均匀分布到各个槽
+    static size_t hash(uint64_t key) {
+        key ^= key >> 30;
+        key *= 0xbf58476d1ce4e5b9ULL;
+        key ^= key >> 27;
+        key *= 0x94d049bb133111ebULL;
+        key ^= key >> 31;
+        return (size_t)key;
+    }
+
+    void rehash(size_t newCapacity) {
+        std::vector<Slot> old;
+        old.swap(m_slots);
+        m_slots.resize(newCapacity);
+        size_t mask = newCapacity - 1;
+        for (const Slot& slot : old) {
+            if (slot.chunk == nullptr) {
+                continue;
+            }
+            size_t i = hash(slot.key) & mask;
+            while (m_slots[i].chunk != nullptr) {
+                i = (i + 1) & mask;
+            }
+            m_slots[i] = slot;
+        }
+    }
+
+    std::vector<Slot> m_slots;
+    size_t m_size;
+
+    // 上次命中缓存（find 是 const，但缓存需要更新）；m_lastChunk 为 nullptr 表示缓存无效
+    mutable uint64_t m_lastKey;
+    mutable Chunk* m_lastChunk;
+};
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef CHUNK_PIPELINE_H
+#define CHUNK_PIPELINE_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Chunk.h"
+#include "LightEngine.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+#include "WorldStorage.h"
+
+// 区块生成/网格流水线：
+// 工作线程执行 initData（或解码存档）、区块内光照计算和网格的 CPU 部分（展开快照 + buildVertices），结果放入完成队列；
+// 主线程（OpenGL 线程）从完成队列取结果，只做 glBufferData 上传
+// 流水线本身不调用 OpenGL，上传由 processCompleted 的回调完成
+// 工作线程数为 0 时所有任务在主线程上串行执行，结果仍经过完成队列，用于确定性对比
+class ChunkPipeline {
+public:
+    explicit ChunkPipeline(int workerCount) : m_meshRequests(0), m_pool(workerCount) {}
+
+    int workerCount() const { return m_pool.threadCount(); }
+
+    // 提交过的网格重建次数（主线程计数）
+    size_t meshRequests() const { return m_meshRequests; }
+
+    // 后台生成地形；区块此时还不能注册到 ChunkMap（其他线程可能正在读写它）
+    // saved 为存档数据（ChunkIO 读出）时解码存档，为空或数据损坏时生成地形
+    void requestGenerate(Chunk* chunk, int chunkX, int chunkZ, ChunkData saved = ChunkData()) {
+        m_pool.submit([this, chunk, chunkX, chunkZ, saved = std::move(saved)]() {
+            if (saved.empty() || !WorldStorage::decodeChunk(saved.data(), saved.size(), chunkX, chunkZ, *chunk)) {
+                chunk->initData(chunkX, chunkZ);
+            }
+            LightEngine::lightChunk(*chunk);   // 光照不存档，加载后重新计算
+            Completed done;
+            done.type = COMPLETED_GENERATE;
+            done.chunk = chunk;
+            pushCompleted(std::move(done));
+        });
+    }
+
+    // 主线程调用：拍下一个段周围 3x3x3 个段的存储快照（写时复制，只增加引用计数），
+    // 展开成 18^3 的方块和光照、生成顶点都在后台进行
+    // 快照之后相邻区块再变化会重新标记 meshDirty，旧结果按版本号丢弃
+    // urgent 为 true 时排在所有尚未开始的任务之前
+    void requestMesh(Chunk* chunk, int sectionIndex, bool urgent = false) {
+        PROFILE_ZONE("ChunkPipeline::requestMesh");
+        ChunkSection* section = chunk->getSection(sectionIndex);
+        if (section == nullptr) {
+            return;
+        }
+        auto snapshot = std::make_shared<Chunk::SectionSnapshot>();
+        chunk->snapshotSection(sectionIndex, *snapshot);
+        section->meshDirty = false;
+        uint32_t version = ++section->meshVersion;
+        section->meshJobsInFlight++;
+        chunk->m_pendingMeshJobs++;
+        m_meshRequests++;
+        MeshMode mode = Chunk::s_meshMode;
+
+        m_pool.submit([this, chunk, sectionIndex, snapshot, version, mode]() mutable {
+            std::unique_ptr<Chunk::PaddedBlocks> blocks(new Chunk::PaddedBlocks());
+            Chunk::expandSnapshot(*snapshot, *blocks);
+            snapshot.reset();   // 尽早释放引用，主线程之后的编辑不必再复制存储
+            Completed done;
+            done.type = COMPLETED_MESH;
+            done.chunk = chunk;
+            done.section = sectionIndex;
+            done.version = version;
+            Chunk::buildVertices(*blocks, mode, done.vertices);
+            pushCompleted(std::move(done));
+        }, urgent);
+    }
+
+    // 主线程调用：处理完成队列
+    // 地形生成完成的区块交给 onGenerated（通常是注册到 ChunkMap）；
+    // 网格结果先放进对应段的 vertices，再交给 onMeshed(chunk, sectionIndex)（通常是 uploadMesh 上传到 GPU）
+    // budgetSeconds < 0 表示处理全部结果，否则超出时间预算后停止，剩余结果留到下一帧
+    // 返回处理的结果数
+    template <typename OnGenerated, typename OnMeshed>
+    size_t processCompleted(OnGenerated onGenerated, OnMeshed onMeshed, double budgetSeconds = -1.0) {
+        PROFILE_ZONE("ChunkPipeline::processCompleted");
+        auto start = std::chrono::steady_clock::now();
+        size_t processed = 0;
+        while (true) {
+            Completed done;
+            {
+                std::lock_guard<std::mutex> lock(m_completedMutex);
+                if (m_completed.empty()) {
+                    break;
+                }
+                done = std::move(m_completed.front());
+                m_completed.pop_front();
+            }
+
+            if (done.type == COMPLETED_GENERATE) {
+                onGenerated(done.chunk);
+            } else {
+                done.chunk->m_pendingMeshJobs--;
+                // 只上传最新一次请求的结果
+                ChunkSection* section = done.chunk->getSection(done.section);
+                if (section != nullptr) {
+                    section->meshJobsInFlight--;
+                }
+                if (section != nullptr && done.version == section->meshVersion) {
+                    section->vertices.swap(done.vertices);
+                    onMeshed(done.chunk, done.section);
+                }
+            }
+            processed++;
+
+            if (budgetSeconds >= 0.0) {
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                if (elapsed.count() >= budgetSeconds) {
+                    break;
+                }
+            }
+        }
+        return processed;
+    }
+
+    // 等待所有已提交的任务执行完（结果仍在完成队列中，需要 processCompleted）
+    void waitIdle() {
+        m_pool.waitIdle();
+    }
+
+private:
+    enum CompletedType {
+        COMPLETED_GENERATE,
+        COMPLETED_MESH
+    };
+
+    struct Completed {
+        CompletedType type = COMPLETED_GENERATE;
+        Chunk* chunk = nullptr;
+        int section = 0;
+        uint32_t version = 0;
+        std::vector<uint32_t> vertices;
+    };
+
+    void pushCompleted(Completed&& done) {
+        std::lock_guard<std::mutex> lock(m_completedMutex);
+        m_completed.push_back(std::move(done));
+    }
+
+    size_t m_meshRequests;
+
+    // 线程池最后声明、最先析构：工作线程退出前完成队列仍然有效
+    std::mutex m_completedMutex;
+    std::deque<Completed> m_completed;
+    ThreadPool m_pool;
+};
+
+#endif
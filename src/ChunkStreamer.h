@@ -0,0 +1,353 @@
+#ifndef CHUNK_STREAMER_H
+#define CHUNK_STREAMER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+#include "Chunk.h"
+#include "ChunkIO.h"
+#include "ChunkMap.h"
+#include "ChunkPipeline.h"
+#include "LightEngine.h"
+#include "MeshArena.h"
+#include "Profiler.h"
+
+// 区块流式加载：以玩家所在区块为中心
+// - 进入加载半径的区块在后台生成地形，由近到远提交（同时在途的生成任务数有上限，
+//   这样玩家移动后新的近处区块不必排在一长串远处任务后面）
+// - 四个相邻区块都已加载的区块才生成网格（边界面一次剔除正确，不会反复重建），同样由近到远
+// - 超出卸载半径（大于加载半径，留出滞后区间，避免在边界来回走动时反复加载/卸载）的区块
+//   从 ChunkMap 移除并释放 CPU 和 GPU 内存；还有网格任务未完成的区块等结果取走后再删除；
+//   它的相邻区块（都在加载半径以外）保留原来的网格，不标记重建，相邻区块重新加载后再重建；
+//   从它传到相邻区块的光会被清掉（LightEngine::queueUnload），重新加载后再从边界传播
+// - 设置了 ChunkIO 时，要加载的区块先由 I/O 线程读取存档（有存档则在工作线程上解码，没有才生成地形），
+//   卸载的区块中需要保存的交给 I/O 线程写回；主线程不读写文件
+// 每帧的光照传播、上传和网格快照受时间预算限制，剩余工作留到下一帧
+class ChunkStreamer {
+public:
+    // arena 为 nullptr 时不上传网格（性能测试中没有 OpenGL 上下文）
+    ChunkStreamer(ChunkMap& chunks, ChunkPipeline& pipeline, MeshArena* arena,
+                  int loadRadius, int unloadRadius)
+        : m_chunks(chunks), m_pipeline(pipeline), m_arena(arena),
+          m_loadRadius(loadRadius), m_unloadRadius(std::max(unloadRadius, loadRadius + 1)),
+          m_maxGenerating(std::max(4, pipeline.workerCount() * 4)),
+          m_budgetSeconds(0.004), m_io(nullptr), m_light(chunks), m_centerX(0), m_centerZ(0), m_unloadedTotal(0) {
+        // 加载半径内的所有偏移，按到中心的距离排序，即为加载优先级
+        for (int dx = -m_loadRadius; dx <= m_loadRadius; dx++) {
+            for (int dz = -m_loadRadius; dz <= m_loadRadius; dz++) {
+                if (dx * dx + dz * dz <= m_loadRadius * m_loadRadius) {
+                    m_loadOrder.push_back({dx, dz});
+                }
+            }
+        }
+        std::stable_sort(m_loadOrder.begin(), m_loadOrder.end(), [](const Offset& a, const Offset& b) {
+            return a.dx * a.dx + a.dz * a.dz < b.dx * b.dx + b.dz * b.dz;
+        });
+    }
+
+    ChunkStreamer(const ChunkStreamer&) = delete;
+    ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+
+    ~ChunkStreamer() {
+        shutdown();
+    }
+
+    // 每帧的时间预算（秒），< 0 表示不限制（启动时一次性加载）
+    void setBudget(double seconds) { m_budgetSeconds = seconds; }
+    double budget() const { return m_budgetSeconds; }
+
+    void setMaxGenerating(int count) { m_maxGenerating = std::max(1, count); }
+
+    // 存档 I/O（nullptr 表示不读写存档，总是生成地形）
+    void setIO(ChunkIO* io) { m_io = io; }
+
+    int loadRadius() const { return m_loadRadius; }
+    int unloadRadius() const { return m_unloadRadius; }
+
+    // 世界坐标所在的区块坐标（向下取整）
+    static int toChunkCoord(float worldCoord) {
+        int block = (int)std::floor(worldCoord);
+        return (block >= 0) ? block / Chunk::CHUNK_SIZE : (block - Chunk::CHUNK_SIZE + 1) / Chunk::CHUNK_SIZE;
+    }
+
+    // 编辑方块（世界坐标）：受影响的段标记为脏，并在下一次 update 中优先提交重建
+    // 同一帧内对同一个段的多次编辑合并为一次重建；光照在 update 中增量更新，光照变化的段一起重建；返回方块是否被修改
+    bool setBlock(int worldX, int y, int worldZ, uint16_t blockType) {
+        uint16_t oldType = m_chunks.getBlock(worldX, y, worldZ);
+        if (!m_chunks.setBlock(worldX, y, worldZ, blockType, &m_editedChunks)) {
+            return false;
+        }
+        m_light.queueBlockUpdate(worldX, y, worldZ, oldType);
+        return true;
+    }
+
+    // 主线程每帧调用：推进光照传播、处理完成的任务和存档读取结果、优先提交编辑后的网格重建、卸载远处区块、
+    // 由近到远提交生成和网格任务
+    void update(int centerX, int centerZ) {
+        PROFILE_ZONE("ChunkStreamer::update");
+        auto start = std::chrono::steady_clock::now();
+        m_centerX = centerX;
+        m_centerZ = centerZ;
+
+        // 光照放在最前面，编辑后的光照通常在同一帧内完成，光照变化的段和编辑一起重建；
+        // 最多用一半预算，大量编辑或区块加载时不挤占上传
+        m_light.process((m_budgetSeconds < 0.0) ? -1.0 : m_budgetSeconds * 0.5, &m_editedChunks);
+
+        m_pipeline.processCompleted(
+            [this](Chunk* chunk) { onGenerated(chunk); },
+            [this](Chunk* chunk, int sectionIndex) {
+                if (m_arena != nullptr) {
+                    chunk->uploadMesh(*m_arena, sectionIndex);
+                }
+            },
+            remainingBudget(start));
+        if (m_io != nullptr) {
+            m_io->processCompleted([this](ChunkIO::Loaded& loaded) { onLoaded(loaded); }, remainingBudget(start));
+        }
+
+        // 编辑过的段插到任务队列最前面，工作线程马上开始重建，结果通常在下一帧即可上传
+        if (!m_editedChunks.empty()) {
+            std::sort(m_editedChunks.begin(), m_editedChunks.end());
+            m_editedChunks.erase(std::unique(m_editedChunks.begin(), m_editedChunks.end()), m_editedChunks.end());
+            // 还有任务在途的段留到下一帧，等任务完成后再优先重建
+            size_t kept = 0;
+            for (Chunk* chunk : m_editedChunks) {
+                if (hasAllNeighbors(chunk) && requestDirtyMeshes(chunk, true)) {
+                    m_editedChunks[kept++] = chunk;
+                }
+            }
+            m_editedChunks.resize(kept);
+        }
+
+        unloadFarChunks();
+        deleteRetiredChunks();
+
+        for (const Offset& offset : m_loadOrder) {
+            int cx = centerX + offset.dx;
+            int cz = centerZ + offset.dz;
+            Chunk* chunk = m_chunks.find(cx, cz);
+            if (chunk == nullptr) {
+                if ((int)m_generating.size() < m_maxGenerating &&
+                    m_generating.insert(ChunkMap::packKey(cx, cz)).second) {
+                    if (m_io != nullptr) {
+                        m_io->requestLoad(cx, cz);
+                    } else {
+                        m_pipeline.requestGenerate(new Chunk(), cx, cz);
+                    }
+                }
+                continue;
+            }
+
+            if (!hasAllNeighbors(chunk)) {
+                continue;
+            }
+            requestDirtyMeshes(chunk, false);
+            if (overBudget(start)) {
+                break;
+            }
+        }
+    }
+
+    // 加载半径内的区块是否全部生成、完成光照传播和网格（启动时等待用）
+    bool isSettled() const {
+        if (!m_generating.empty() || !m_light.idle()) {
+            return false;
+        }
+        for (const Offset& offset : m_loadOrder) {
+            const Chunk* chunk = m_chunks.find(m_centerX + offset.dx, m_centerZ + offset.dz);
+            if (chunk == nullptr || chunk->m_pendingMeshJobs > 0) {
+                return false;
+            }
+            if (!hasAllNeighbors(chunk)) {
+                continue;
+            }
+            for (int s = 0; s < Chunk::SECTION_COUNT; s++) {
+                const ChunkSection* section = chunk->getSection(s);
+                if (section != nullptr && section->meshDirty) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // 统计
+    int generatingCount() const { return (int)m_generating.size(); }
+    int retiredCount() const { return (int)m_retired.size(); }
+    size_t loadedCount() const { return m_chunks.size(); }
+    size_t unloadedTotal() const { return m_unloadedTotal; }
+
+    // 等待后台任务结束，保存并释放所有区块（在销毁 MeshArena 之前调用）
+    void shutdown() {
+        m_pipeline.waitIdle();
+        m_pipeline.processCompleted(
+            [this](Chunk* chunk) {
+                m_generating.erase(ChunkMap::packKey(chunk->m_chunkX, chunk->m_chunkZ));
+                delete chunk;
+            },
+            [](Chunk*, int) {});
+
+        std::vector<Chunk*> loaded;
+        m_chunks.forEach([&loaded](int cx, int cz, Chunk* chunk) {
+            loaded.push_back(chunk);
+        });
+        m_chunks.clear();
+        m_light.clear();
+        for (Chunk* chunk : loaded) {
+            releaseChunk(chunk);
+        }
+        deleteRetiredChunks();
+
+        // 等待存档全部写盘；还没取走的读取结果不再需要
+        if (m_io != nullptr) {
+            m_io->waitIdle();
+            m_io->discardCompleted();
+        }
+        m_generating.clear();
+    }
+
+private:
+    struct Offset {
+        int dx, dz;
+    };
+
+    // 本帧剩余的时间预算（不限制时为 -1）
+    double remainingBudget(std::chrono::steady_clock::time_point start) const {
+        if (m_budgetSeconds < 0.0) {
+            return -1.0;
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return std::max(0.0, m_budgetSeconds - elapsed.count());
+    }
+
+    bool overBudget(std::chrono::steady_clock::time_point start) const {
+        if (m_budgetSeconds < 0.0) {
+            return false;
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() >= m_budgetSeconds;
+    }
+
+    // 提交脏段的网格重建；已有任务在进行的段先等它完成（保留脏标记），同一段最多一个任务在途
+    // 返回是否有这样被推迟的段
+    bool requestDirtyMeshes(Chunk* chunk, bool urgent) {
+        bool deferred = false;
+        for (int s = 0; s < Chunk::SECTION_COUNT; s++) {
+            ChunkSection* section = chunk->getSection(s);
+            if (section == nullptr || !section->meshDirty) {
+                continue;
+            }
+            if (section->meshJobsInFlight == 0) {
+                m_pipeline.requestMesh(chunk, s, urgent);
+            } else {
+                deferred = true;
+            }
+        }
+        return deferred;
+    }
+
+    static bool hasAllNeighbors(const Chunk* chunk) {
+        for (int dir = 0; dir < 4; dir++) {
+            if (chunk->m_neighbors[dir] == nullptr) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int distanceSquared(int cx, int cz) const {
+        int dx = cx - m_centerX;
+        int dz = cz - m_centerZ;
+        return dx * dx + dz * dz;
+    }
+
+    // 存档读取完成：交给工作线程解码（没有存档则生成地形）；玩家已走远则放弃
+    void onLoaded(ChunkIO::Loaded& loaded) {
+        if (distanceSquared(loaded.chunkX, loaded.chunkZ) > m_unloadRadius * m_unloadRadius) {
+            m_generating.erase(ChunkMap::packKey(loaded.chunkX, loaded.chunkZ));
+            return;
+        }
+        m_pipeline.requestGenerate(new Chunk(), loaded.chunkX, loaded.chunkZ,
+                                   loaded.found ? std::move(loaded.data) : ChunkData());
+    }
+
+    // 生成完成：仍在卸载半径内则注册，否则（玩家已走远）直接丢弃
+    void onGenerated(Chunk* chunk) {
+        m_generating.erase(ChunkMap::packKey(chunk->m_chunkX, chunk->m_chunkZ));
+        if (distanceSquared(chunk->m_chunkX, chunk->m_chunkZ) > m_unloadRadius * m_unloadRadius) {
+            delete chunk;
+            return;
+        }
+        m_chunks.insert(chunk->m_chunkX, chunk->m_chunkZ, chunk);
+        m_light.queueBorders(*chunk);   // 光跨过与已加载的相邻区块之间的边界
+    }
+
+    void unloadFarChunks() {
+        const int limit = m_unloadRadius * m_unloadRadius;
+        m_farChunks.clear();
+        m_chunks.forEach([this, limit](int cx, int cz, Chunk* chunk) {
+            if (distanceSquared(cx, cz) > limit) {
+                m_farChunks.push_back(chunk);
+            }
+        });
+        for (Chunk* chunk : m_farChunks) {
+            m_chunks.erase(chunk->m_chunkX, chunk->m_chunkZ);
+            m_light.queueUnload(*chunk);   // 清掉从它传到相邻区块的光
+            releaseChunk(chunk);
+            m_unloadedTotal++;
+        }
+    }
+
+    // 写回存档（只写新生成或编辑过的区块）、释放网格；还有后台网格任务时先放进待删除列表
+    void releaseChunk(Chunk* chunk) {
+        m_editedChunks.erase(std::remove(m_editedChunks.begin(), m_editedChunks.end(), chunk), m_editedChunks.end());
+        if (m_io != nullptr && chunk->m_needsSave) {
+            m_io->requestSave(*chunk);
+        }
+        chunk->cancelPendingMeshes();
+        if (m_arena != nullptr) {
+            chunk->releaseMesh(*m_arena);
+        }
+        if (chunk->m_pendingMeshJobs > 0) {
+            m_retired.push_back(chunk);
+        } else {
+            delete chunk;
+        }
+    }
+
+    void deleteRetiredChunks() {
+        for (size_t i = 0; i < m_retired.size(); ) {
+            if (m_retired[i]->m_pendingMeshJobs == 0) {
+                delete m_retired[i];
+                m_retired[i] = m_retired.back();
+                m_retired.pop_back();
+            } else {
+                i++;
+            }
+        }
+    }
+
+    ChunkMap& m_chunks;
+    ChunkPipeline& m_pipeline;
+    MeshArena* m_arena;
+
+    int m_loadRadius;
+    int m_unloadRadius;
+    int m_maxGenerating;
+    double m_budgetSeconds;
+    ChunkIO* m_io;
+    LightEngine m_light;
+
+    int m_centerX, m_centerZ;
+    std::vector<Offset> m_loadOrder;          // 按距离排序的加载偏移
+    std::unordered_set<uint64_t> m_generating; // 正在读取存档或后台生成的区块坐标（ChunkMap::packKey）
+    std::vector<Chunk*> m_retired;            // 已卸载、等待网格任务结果取走后删除
+    std::vector<Chunk*> m_farChunks;          // unloadFarChunks 的临时列表
+    std::vector<Chunk*> m_editedChunks;       // 上次 update 之后编辑过方块的区块（可能重复）
+    size_t m_unloadedTotal;
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef DAY_CYCLE_H
+#define DAY_CYCLE_H
+
+#include <cmath>
+#include <glm/glm.hpp>
+
+// 昼夜循环：时间只决定一个全局的天空亮度（片段着色器的 uniform skyBrightness）和背景色
+// 顶点中天空光和方块光分开存储，着色器把天空光乘以天空亮度后再与方块光取较大值，
+// 所以时间变化不需要重新计算光照，也不需要重建任何网格，每帧只写一次 uniform
+// 时间 timeOfDay 在 [0, 1) 内循环：0 午夜，0.25 日出，0.5 正午，0.75 日落
+class DayCycle {
+public:
+    static constexpr float DAY_SECONDS = 600.0f;           // 一整天对应的现实秒数
+    static constexpr float MIN_SKY_BRIGHTNESS = 0.2f;      // 午夜的天空亮度（地表不至于全黑）
+
+    explicit DayCycle(float timeOfDay = 0.3f) { setTimeOfDay(timeOfDay); }
+
+    float timeOfDay() const { return m_time; }
+
+    void setTimeOfDay(float timeOfDay) {
+        m_time = timeOfDay - std::floor(timeOfDay);
+    }
+
+    // 推进现实时间 seconds 秒
+    void advance(float seconds) {
+        setTimeOfDay(m_time + seconds / DAY_SECONDS);
+    }
+
+    // 太阳高度：正午 1，日出日落 0，午夜 -1
+    float sunHeight() const {
+        return std::sin((m_time - 0.25f) * 2.0f * 3.14159265f);
+    }
+
+    // 白天的程度（0 ~ 1）：太阳在地平线附近时平滑过渡（黄昏和黎明）
+    float daylight() const {
+        float t = glm::clamp((sunHeight() + 0.2f) / 0.5f, 0.0f, 1.0f);
+        return t * t * (3.0f - 2.0f * t);
+    }
+
+    // 乘在天空光上的亮度（着色器 uniform skyBrightness）
+    float skyBrightness() const {
+        return MIN_SKY_BRIGHTNESS + (1.0f - MIN_SKY_BRIGHTNESS) * daylight();
+    }
+
+    // 背景（天空）颜色：夜晚的深蓝到白天的天蓝
+    glm::vec3 skyColor() const {
+        return glm::mix(glm::vec3(0.02f, 0.03f, 0.08f), glm::vec3(0.5f, 0.7f, 1.0f), daylight());
+    }
+
+private:
+    float m_time;
+};
+
+#endif
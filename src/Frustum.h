@@ -0,0 +1,56 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+// 视锥体：从 projection * view 矩阵中提取 6 个裁剪平面（Gribb-Hartmann 方法）
+// 用于在绘制前剔除完全位于视锥外的区块
+class Frustum {
+public:
+    // 平面方程 ax + by + cz + d = 0，法线指向视锥内部
+    // 顺序：左、右、下、上、近、远
+    glm::vec4 planes[6];
+
+    Frustum() {}
+
+    explicit Frustum(const glm::mat4& viewProjection) {
+        update(viewProjection);
+    }
+
+    void update(const glm::mat4& m) {
+        // glm 是列主序：m[col][row]，取出矩阵的四行
+        glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+        glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+        glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+        glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+        planes[0] = row3 + row0;   // 左
+        planes[1] = row3 - row0;   // 右
+        planes[2] = row3 + row1;   // 下
+        planes[3] = row3 - row1;   // 上
+        planes[4] = row3 + row2;   // 近
+        planes[5] = row3 - row2;   // 远
+
+        // 归一化，便于需要真实距离的场合
+        for (int i = 0; i < 6; i++) {
+            planes[i] /= glm::length(glm::vec3(planes[i]));
+        }
+    }
+
+    // AABB 是否（至少部分）位于视锥内
+    // 对每个平面只测试沿法线方向最远的角点（p-vertex），它在平面外侧则整个盒子都在外侧
+    bool intersectsAABB(const glm::vec3& min, const glm::vec3& max) const {
+        for (int i = 0; i < 6; i++) {
+            const glm::vec4& p = planes[i];
+            glm::vec3 farthest(p.x >= 0.0f ? max.x : min.x,
+                               p.y >= 0.0f ? max.y : min.y,
+                               p.z >= 0.0f ? max.z : min.z);
+            if (p.x * farthest.x + p.y * farthest.y + p.z * farthest.z + p.w < 0.0f) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,580 @@
+#ifndef LIGHT_ENGINE_H
+#define LIGHT_ENGINE_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Chunk.h"
+#include "ChunkMap.h"
+#include "LightStorage.h"
+#include "Profiler.h"
+
+// 光照通道
+enum LightChannel {
+    LIGHT_SKY = 0,     // 天空光：从世界顶部垂直向下不衰减，其余方向每格减 1
+    LIGHT_BLOCK = 1    // 方块光：从发光方块向六个方向每格减 1
+};
+
+// 体素光照：天空光先按列计算（露天的格子为 15），再和方块光一样用 BFS 洪水填充；结果存在 Chunk::m_light
+// - lightChunk：工作线程上计算一个还没加入 ChunkMap 的区块内部的光照（ChunkPipeline 在生成/解码后调用）
+// - 跨区块的部分在主线程上增量进行（ChunkStreamer 持有一个 LightEngine）：
+//   queueBorders（区块加入 ChunkMap）、queueBlockUpdate（方块变化）、queueUnload（区块移出 ChunkMap）只放入种子，
+//   process 在每帧的时间预算内推进 BFS，剩下的留到下一帧；移除队列清掉依赖旧光源的光，添加队列从剩下的光源重新填充，
+//   只访问光照真正变化的格子。多次编辑的种子合并在同一组队列里，先处理完移除队列再处理添加队列
+// - 光照变化的格子所在的段（以及以它为面前方的相邻段）标记为需要重建网格；缺少相邻区块的区块不标记
+//   （它不会生成网格，相邻区块加载时 ChunkMap::linkNeighbors 会把它整个标记）
+// - 区块卸载时，相邻区块边界上比它暗的格子可能是从它传过来的光，作为移除的种子清掉，再从剩下的光源重新填充
+// 区块加入 ChunkMap 后由主线程持有（与 ChunkMap::setBlock 相同）；工作线程只处理还没加入 ChunkMap 的区块，
+// 不会与主线程同时访问同一个区块。队列中只存世界坐标，区块卸载后落在它上面的格子直接跳过
+class LightEngine {
+public:
+    static const int MAX_LIGHT = 15;
+
+    // 区块内的光照（区块外当作不存在，跨区块的部分由 propagateBorders 补上）；返回 BFS 改变的格子数
+    static size_t lightChunk(Chunk& chunk) {
+        PROFILE_ZONE("LightEngine::lightChunk");
+        const int N = Chunk::CHUNK_SIZE;
+        LightEngine engine(nullptr, &chunk);
+
+        // 每一列最高的挡光方块（没有时为 -1）；只从最高的非空段往下找
+        int topSection = Chunk::SECTION_COUNT - 1;
+        while (topSection >= 0 && chunk.getSection(topSection) == nullptr) {
+            topSection--;
+        }
+        int heights[N][N];
+        int maxHeight = -1;
+        int minHeight = Chunk::WORLD_HEIGHT;
+        for (int x = 0; x < N; x++) {
+            for (int z = 0; z < N; z++) {
+                int y = (topSection + 1) * N - 1;
+                while (y >= 0 && !isOpaqueBlock(chunk.getBlock(x, y, z))) {
+                    y--;
+                }
+                heights[x][z] = y;
+                maxHeight = std::max(maxHeight, y);
+                minHeight = std::min(minHeight, y);
+            }
+        }
+
+        // 按列：最高的挡光方块以上为 15 级天空光，以下全黑；整段在地表以上或以下时不分配数组
+        uint8_t dense[LightStorage::VOLUME];
+        for (int s = 0; s < Chunk::SECTION_COUNT; s++) {
+            int baseY = s * N;
+            if (baseY > maxHeight) {
+                chunk.m_light[s].fill(LightStorage::FULL_SKY);
+                continue;
+            }
+            if (baseY + N - 1 <= minHeight) {
+                chunk.m_light[s].fill(0);
+                continue;
+            }
+            for (int x = 0; x < N; x++) {
+                for (int y = 0; y < N; y++) {
+                    for (int z = 0; z < N; z++) {
+                        dense[LightStorage::index(x, y, z)] = (baseY + y > heights[x][z]) ? LightStorage::FULL_SKY : 0;
+                    }
+                }
+            }
+            chunk.m_light[s].assign(dense);
+        }
+
+        // 天空光的种子：旁边一列在这个高度还被遮住的露天格子（光从这里横向照进悬崖下、洞口）
+        const int baseX = chunk.m_chunkX * N;
+        const int baseZ = chunk.m_chunkZ * N;
+        for (int x = 0; x < N; x++) {
+            for (int z = 0; z < N; z++) {
+                for (int d = 0; d < 6; d++) {
+                    int nx = x + DIRECTIONS[d][0];
+                    int nz = z + DIRECTIONS[d][2];
+                    if (DIRECTIONS[d][1] != 0 || nx < 0 || nx >= N || nz < 0 || nz >= N) {
+                        continue;
+                    }
+                    for (int y = heights[x][z] + 1; y < heights[nx][nz]; y++) {
+                        engine.m_add[LIGHT_SKY].push_back({baseX + x, y, baseZ + z, MAX_LIGHT});
+                    }
+                }
+            }
+        }
+        engine.propagate(LIGHT_SKY);
+
+        // 方块光的种子：发光方块（只扫描调色板中有发光方块的段）
+        for (int s = 0; s < Chunk::SECTION_COUNT; s++) {
+            const ChunkSection* section = chunk.getSection(s);
+            if (section == nullptr) {
+                continue;
+            }
+            const std::vector<uint16_t>& palette = section->blocks.palette();
+            bool emits = false;
+            for (uint16_t type : palette) {
+                emits = emits || blockLightEmission(type) > 0;
+            }
+            if (!emits) {
+                continue;
+            }
+            for (int x = 0; x < N; x++) {
+                for (int y = 0; y < N; y++) {
+                    for (int z = 0; z < N; z++) {
+                        int emission = blockLightEmission(section->blocks.get(x, y, z));
+                        if (emission > 0) {
+                            engine.setLevel(&chunk, baseX + x, s * N + y, baseZ + z, LIGHT_BLOCK, emission);
+                            engine.m_add[LIGHT_BLOCK].push_back({baseX + x, s * N + y, baseZ + z, emission});
+                        }
+                    }
+                }
+            }
+        }
+        engine.propagate(LIGHT_BLOCK);
+        return engine.m_changed;
+    }
+
+    // 主线程上的增量光照，跨区块传播
+    explicit LightEngine(ChunkMap& chunks) : LightEngine(&chunks, nullptr) {}
+
+    // 以下两个静态函数立即完成全部传播（性能测试和全量重算用）；返回改变的格子数
+    static size_t propagateBorders(ChunkMap& chunks, Chunk& chunk) {
+        LightEngine engine(chunks);
+        engine.queueBorders(chunk);
+        return engine.process(-1.0);
+    }
+
+    static size_t updateBlock(ChunkMap& chunks, int worldX, int y, int worldZ, uint16_t oldType,
+                              std::vector<Chunk*>* touched = nullptr) {
+        LightEngine engine(chunks);
+        engine.queueBlockUpdate(worldX, y, worldZ, oldType);
+        return engine.process(-1.0, touched);
+    }
+
+    // 区块刚加入 ChunkMap：在 process 中比较它与四个相邻区块紧贴边界的两层，
+    // 亮的一侧比暗的一侧高 2 级以上时从亮的一侧开始传播
+    // 落在这个区块里的移除种子来自同一位置上已经卸载的旧区块，与新区块的光照无关，丢掉
+    void queueBorders(const Chunk& chunk) {
+        m_pendingBorders.push_back(ChunkMap::packKey(chunk.m_chunkX, chunk.m_chunkZ));
+        for (int channel = 0; channel < 2; channel++) {
+            std::vector<Node>& queue = m_remove[channel];
+            size_t kept = m_removeHead[channel];
+            for (size_t i = m_removeHead[channel]; i < queue.size(); i++) {
+                if ((queue[i].x >> 4) != chunk.m_chunkX || (queue[i].z >> 4) != chunk.m_chunkZ) {
+                    queue[kept++] = queue[i];
+                }
+            }
+            queue.resize(kept);
+        }
+    }
+
+    // 世界坐标 (x, y, z) 的方块已经从 oldType 改成了当前的方块：放入两种光照的种子
+    void queueBlockUpdate(int worldX, int y, int worldZ, uint16_t oldType) {
+        m_hasCached = false;
+        Chunk* chunk = chunkAt(worldX, worldZ);
+        if (chunk == nullptr || y < 0 || y >= Chunk::WORLD_HEIGHT) {
+            return;
+        }
+        uint16_t newType = chunk->getBlock(worldX & (Chunk::CHUNK_SIZE - 1), y, worldZ & (Chunk::CHUNK_SIZE - 1));
+        bool opaque = isOpaqueBlock(newType);
+
+        for (LightChannel channel : {LIGHT_SKY, LIGHT_BLOCK}) {
+            // 1. 新方块挡光，或者旧方块是光源：清掉这一格的光，依赖它的光由移除队列清掉
+            int current = level(chunk, worldX, y, worldZ, channel);
+            bool wasSource = (channel == LIGHT_BLOCK) && blockLightEmission(oldType) > 0;
+            if ((opaque || wasSource) && current > 0) {
+                setLevel(chunk, worldX, y, worldZ, channel, 0);
+                m_remove[channel].push_back({worldX, y, worldZ, current});
+            }
+
+            // 2. 新的光源；挖开的格子让周围的光照进来（世界顶层的格子直接露天）
+            int emission = (channel == LIGHT_BLOCK) ? blockLightEmission(newType) : 0;
+            if (emission > 0) {
+                setLevel(chunk, worldX, y, worldZ, channel, emission);
+                m_add[channel].push_back({worldX, y, worldZ, emission});
+            }
+            if (!opaque) {
+                if (channel == LIGHT_SKY && y == Chunk::WORLD_HEIGHT - 1) {
+                    setLevel(chunk, worldX, y, worldZ, channel, MAX_LIGHT);
+                }
+                m_add[channel].push_back({worldX, y, worldZ, 0});
+                for (int d = 0; d < 6; d++) {
+                    m_add[channel].push_back({worldX + DIRECTIONS[d][0], y + DIRECTIONS[d][1],
+                                              worldZ + DIRECTIONS[d][2], 0});
+                }
+            }
+        }
+    }
+
+    // 区块已经从 ChunkMap 移除（对象还没有释放）：相邻区块边界上比它暗的格子可能依赖它的光，清零后作为移除的种子；
+    // 不比它暗的格子不依赖它，保持不变
+    void queueUnload(const Chunk& chunk) {
+        const int N = Chunk::CHUNK_SIZE;
+        m_hasCached = false;
+        m_touched.erase(std::remove(m_touched.begin(), m_touched.end(), &chunk), m_touched.end());
+        for (int dir = 0; dir < 4; dir++) {
+            Chunk* neighbor = m_chunks->find(chunk.m_chunkX + NEIGHBOR_OFFSETS[dir][0],
+                                             chunk.m_chunkZ + NEIGHBOR_OFFSETS[dir][1]);
+            if (neighbor == nullptr) {
+                continue;
+            }
+            for (int s = 0; s < Chunk::SECTION_COUNT; s++) {
+                const LightStorage& a = chunk.m_light[s];
+                const LightStorage& b = neighbor->m_light[s];
+                if ((a.isUniform() && b.isUniform() && a.uniformValue() == b.uniformValue()) ||
+                    (a.isUniform() && a.uniformValue() == 0)) {
+                    continue;
+                }
+                for (int i = 0; i < N; i++) {
+                    int ax, az, bx, bz;
+                    borderCells(dir, i, ax, az, bx, bz);
+                    for (int ly = 0; ly < N; ly++) {
+                        uint8_t la = a.get(ax, ly, az);
+                        uint8_t lb = b.get(bx, ly, bz);
+                        int x = neighbor->m_chunkX * N + bx;
+                        int y = s * N + ly;
+                        int z = neighbor->m_chunkZ * N + bz;
+                        seedDependent(neighbor, x, y, z, LIGHT_SKY, LightStorage::skyOf(la), LightStorage::skyOf(lb));
+                        seedDependent(neighbor, x, y, z, LIGHT_BLOCK, LightStorage::blockOf(la), LightStorage::blockOf(lb));
+                    }
+                }
+            }
+        }
+    }
+
+    // 推进排队的传播，直到全部完成或用完 budgetSeconds（< 0 表示不限制）
+    // touched 不为空时追加光照变化影响到网格的区块（每个区块一次）；返回改变的格子数
+    size_t process(double budgetSeconds, std::vector<Chunk*>* touched = nullptr) {
+        PROFILE_ZONE("LightEngine::process");
+        auto start = std::chrono::steady_clock::now();
+        m_hasCached = false;   // 两次调用之间区块可能加载或卸载
+        size_t changed = m_changed;
+        while (true) {
+            if (budgetSeconds >= 0.0) {
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                if (elapsed.count() >= budgetSeconds) {
+                    break;
+                }
+            }
+            if (!m_pendingBorders.empty()) {
+                seedBorders(m_pendingBorders.back());
+                m_pendingBorders.pop_back();
+                continue;
+            }
+            // 每个通道先处理完移除队列再处理添加队列；两个通道互不影响
+            bool worked = false;
+            for (LightChannel channel : {LIGHT_SKY, LIGHT_BLOCK}) {
+                if (m_removeHead[channel] < m_remove[channel].size()) {
+                    unpropagate(channel, BATCH_NODES);
+                    worked = true;
+                    break;
+                }
+                if (m_addHead[channel] < m_add[channel].size()) {
+                    propagate(channel, BATCH_NODES);
+                    worked = true;
+                    break;
+                }
+            }
+            if (!worked) {
+                break;
+            }
+        }
+
+        if (touched != nullptr) {
+            touched->insert(touched->end(), m_touched.begin(), m_touched.end());
+        }
+        m_touched.clear();
+        return m_changed - changed;
+    }
+
+    // 没有排队的传播
+    bool idle() const {
+        return m_pendingBorders.empty() &&
+               m_removeHead[LIGHT_SKY] == m_remove[LIGHT_SKY].size() && m_addHead[LIGHT_SKY] == m_add[LIGHT_SKY].size() &&
+               m_removeHead[LIGHT_BLOCK] == m_remove[LIGHT_BLOCK].size() && m_addHead[LIGHT_BLOCK] == m_add[LIGHT_BLOCK].size();
+    }
+
+    // 丢掉所有排队的传播（所有区块卸载后）
+    void clear() {
+        m_pendingBorders.clear();
+        for (int channel = 0; channel < 2; channel++) {
+            m_add[channel].clear();
+            m_remove[channel].clear();
+            m_addHead[channel] = 0;
+            m_removeHead[channel] = 0;
+        }
+        m_touched.clear();
+        m_hasCached = false;
+    }
+
+private:
+    // 队列中的格子（世界坐标）；level 在移除队列中为清除前的亮度，在添加队列中不使用（按格子当前的亮度传播）
+    struct Node {
+        int x, y, z;
+        int level;
+    };
+
+    // 六个方向；DOWN 为向下（天空光 15 级向下不衰减）
+    static constexpr int DIRECTIONS[6][3] = {
+        {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}
+    };
+    static const int DOWN = 3;
+
+    // 与 ChunkNeighbor 顺序一致的区块坐标偏移
+    static constexpr int NEIGHBOR_OFFSETS[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+
+    // process 每推进这么多个格子检查一次时间
+    static const size_t BATCH_NODES = 256;
+
+    // chunks 为空时只在 only 这一个区块内传播（工作线程）
+    LightEngine(ChunkMap* chunks, Chunk* only)
+        : m_chunks(chunks), m_only(only), m_cachedChunk(nullptr), m_cachedX(0), m_cachedZ(0),
+          m_hasCached(false), m_addHead{0, 0}, m_removeHead{0, 0}, m_changed(0) {}
+
+    // 区块与 dir 方向的相邻区块之间，边界两侧第 i 对格子的区块内坐标（a 在区块内，b 在相邻区块内）
+    static void borderCells(int dir, int i, int& ax, int& az, int& bx, int& bz) {
+        const int N = Chunk::CHUNK_SIZE;
+        ax = (dir == NEIGHBOR_NEG_X) ? 0 : (dir == NEIGHBOR_POS_X) ? N - 1 : i;
+        az = (dir == NEIGHBOR_NEG_Z) ? 0 : (dir == NEIGHBOR_POS_Z) ? N - 1 : i;
+        bx = (dir == NEIGHBOR_NEG_X) ? N - 1 : (dir == NEIGHBOR_POS_X) ? 0 : i;
+        bz = (dir == NEIGHBOR_NEG_Z) ? N - 1 : (dir == NEIGHBOR_POS_Z) ? 0 : i;
+    }
+
+    // queueBorders 排队的区块（还在 ChunkMap 中时）：边界两侧亮度相差 2 级以上的格子放进添加队列
+    void seedBorders(uint64_t key) {
+        const int N = Chunk::CHUNK_SIZE;
+        Chunk* chunk = m_chunks->find(ChunkMap::keyX(key), ChunkMap::keyZ(key));
+        if (chunk == nullptr) {
+            return;
+        }
+        for (int dir = 0; dir < 4; dir++) {
+            Chunk* neighbor = chunk->m_neighbors[dir];
+            if (neighbor == nullptr) {
+                continue;
+            }
+            for (int s = 0; s < Chunk::SECTION_COUNT; s++) {
+                const LightStorage& a = chunk->m_light[s];
+                const LightStorage& b = neighbor->m_light[s];
+                if (a.isUniform() && b.isUniform() && a.uniformValue() == b.uniformValue()) {
+                    continue;
+                }
+                for (int i = 0; i < N; i++) {
+                    int ax, az, bx, bz;
+                    borderCells(dir, i, ax, az, bx, bz);
+                    for (int ly = 0; ly < N; ly++) {
+                        uint8_t la = a.get(ax, ly, az);
+                        uint8_t lb = b.get(bx, ly, bz);
+                        int y = s * N + ly;
+                        Node nodeA = {chunk->m_chunkX * N + ax, y, chunk->m_chunkZ * N + az, 0};
+                        Node nodeB = {neighbor->m_chunkX * N + bx, y, neighbor->m_chunkZ * N + bz, 0};
+                        seedBrighter(LightStorage::skyOf(la), LightStorage::skyOf(lb), nodeA, nodeB, m_add[LIGHT_SKY]);
+                        seedBrighter(LightStorage::blockOf(la), LightStorage::blockOf(lb), nodeA, nodeB, m_add[LIGHT_BLOCK]);
+                    }
+                }
+            }
+        }
+    }
+
+    // 卸载的区块边界上亮度为 a，相邻区块的格子亮度为 b：b 比 a 暗时可能是从它传过来的，清零后放进移除队列
+    // （与 unpropagate 相同：这一格本身是光源时保留它自己的光）
+    void seedDependent(Chunk* chunk, int worldX, int y, int worldZ, LightChannel channel, int a, int b) {
+        if (b == 0 || b >= a) {
+            return;
+        }
+        setLevel(chunk, worldX, y, worldZ, channel, 0);
+        m_remove[channel].push_back({worldX, y, worldZ, b});
+        int emission = (channel == LIGHT_BLOCK) ?
+            blockLightEmission(chunk->getBlock(worldX & (Chunk::CHUNK_SIZE - 1), y, worldZ & (Chunk::CHUNK_SIZE - 1))) : 0;
+        if (emission > 0) {
+            setLevel(chunk, worldX, y, worldZ, channel, emission);
+            m_add[channel].push_back({worldX, y, worldZ, emission});
+        }
+    }
+
+    static void seedBrighter(int a, int b, const Node& nodeA, const Node& nodeB, std::vector<Node>& seeds) {
+        if (a > b + 1) {
+            seeds.push_back(nodeA);
+        } else if (b > a + 1) {
+            seeds.push_back(nodeB);
+        }
+    }
+
+    // 世界方块坐标所在的区块（没有加载时为 nullptr），缓存上一次的结果
+    Chunk* chunkAt(int worldX, int worldZ) {
+        int chunkX = worldX >> 4;   // CHUNK_SIZE == 16，算术右移即向下取整
+        int chunkZ = worldZ >> 4;
+        if (m_hasCached && chunkX == m_cachedX && chunkZ == m_cachedZ) {
+            return m_cachedChunk;
+        }
+        if (m_chunks != nullptr) {
+            m_cachedChunk = m_chunks->find(chunkX, chunkZ);
+        } else {
+            m_cachedChunk = (m_only->m_chunkX == chunkX && m_only->m_chunkZ == chunkZ) ? m_only : nullptr;
+        }
+        m_cachedX = chunkX;
+        m_cachedZ = chunkZ;
+        m_hasCached = true;
+        return m_cachedChunk;
+    }
+
+    static int level(const Chunk* chunk, int worldX, int y, int worldZ, LightChannel channel) {
+        uint8_t light = chunk->getLight(worldX & (Chunk::CHUNK_SIZE - 1), y, worldZ & (Chunk::CHUNK_SIZE - 1));
+        return (channel == LIGHT_SKY) ? LightStorage::skyOf(light) : LightStorage::blockOf(light);
+    }
+
+    void setLevel(Chunk* chunk, int worldX, int y, int worldZ, LightChannel channel, int value) {
+        int localX = worldX & (Chunk::CHUNK_SIZE - 1);
+        int localZ = worldZ & (Chunk::CHUNK_SIZE - 1);
+        uint8_t light = chunk->getLight(localX, y, localZ);
+        light = (channel == LIGHT_SKY) ? LightStorage::pack(value, LightStorage::blockOf(light))
+                                       : LightStorage::pack(LightStorage::skyOf(light), value);
+        chunk->setLight(localX, y, localZ, light);
+        m_changed++;
+        if (m_only == nullptr) {
+            markChanged(chunk, localX, y, localZ);
+        }
+    }
+
+    // 这一格是它六个方向上的方块的面前方：标记这一格所在的段，以及这些方块所在的相邻段
+    // 缺少相邻区块的区块不标记：它不会生成网格，缺少的相邻区块加载时整个区块都会被标记
+    void markChanged(Chunk* chunk, int localX, int y, int localZ) {
+        const int N = Chunk::CHUNK_SIZE;
+        int section = y / N;
+        int localY = y % N;
+        if (hasAllNeighbors(chunk)) {
+            chunk->markSectionDirty(section);
+            if (localY == 0) {
+                chunk->markSectionDirty(section - 1);
+            } else if (localY == N - 1) {
+                chunk->markSectionDirty(section + 1);
+            }
+            touch(chunk);
+        }
+
+        Chunk* xNeighbor = (localX == 0) ? chunk->m_neighbors[NEIGHBOR_NEG_X] :
+                           (localX == N - 1) ? chunk->m_neighbors[NEIGHBOR_POS_X] : nullptr;
+        Chunk* zNeighbor = (localZ == 0) ? chunk->m_neighbors[NEIGHBOR_NEG_Z] :
+                           (localZ == N - 1) ? chunk->m_neighbors[NEIGHBOR_POS_Z] : nullptr;
+        for (Chunk* neighbor : {xNeighbor, zNeighbor}) {
+            if (neighbor != nullptr && hasAllNeighbors(neighbor)) {
+                neighbor->markSectionDirty(section);
+                touch(neighbor);
+            }
+        }
+    }
+
+    static bool hasAllNeighbors(const Chunk* chunk) {
+        for (int dir = 0; dir < 4; dir++) {
+            if (chunk->m_neighbors[dir] == nullptr) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void touch(Chunk* chunk) {
+        if (std::find(m_touched.begin(), m_touched.end(), chunk) == m_touched.end()) {
+            m_touched.push_back(chunk);
+        }
+    }
+
+    // 添加队列：从队列中的格子按当前亮度向六个方向扩散，只写入比原来更亮的值
+    // 最多处理 maxNodes 个格子，剩下的下次继续；队列处理完时清空
+    void propagate(LightChannel channel, size_t maxNodes = SIZE_MAX) {
+        std::vector<Node>& queue = m_add[channel];
+        size_t& head = m_addHead[channel];
+        for (size_t processed = 0; head < queue.size() && processed < maxNodes; head++, processed++) {
+            Node node = queue[head];
+            if (node.y < 0 || node.y >= Chunk::WORLD_HEIGHT) {
+                continue;
+            }
+            Chunk* chunk = chunkAt(node.x, node.z);
+            if (chunk == nullptr) {
+                continue;
+            }
+            int current = level(chunk, node.x, node.y, node.z, channel);
+            if (current <= 1) {
+                continue;
+            }
+            for (int d = 0; d < 6; d++) {
+                int nx = node.x + DIRECTIONS[d][0];
+                int ny = node.y + DIRECTIONS[d][1];
+                int nz = node.z + DIRECTIONS[d][2];
+                if (ny < 0 || ny >= Chunk::WORLD_HEIGHT) {
+                    continue;
+                }
+                Chunk* neighbor = chunkAt(nx, nz);
+                if (neighbor == nullptr ||
+                    isOpaqueBlock(neighbor->getBlock(nx & (Chunk::CHUNK_SIZE - 1), ny, nz & (Chunk::CHUNK_SIZE - 1)))) {
+                    continue;
+                }
+                int next = (channel == LIGHT_SKY && d == DOWN && current == MAX_LIGHT) ? MAX_LIGHT : current - 1;
+                if (level(neighbor, nx, ny, nz, channel) >= next) {
+                    continue;
+                }
+                setLevel(neighbor, nx, ny, nz, channel, next);
+                queue.push_back({nx, ny, nz, next});
+            }
+        }
+        if (head == queue.size()) {
+            queue.clear();
+            head = 0;
+        }
+    }
+
+    // 移除队列：队列中的格子已经清零；相邻格子比它暗（或是它向下不衰减的天空光）说明依赖它，一并清零继续移除，
+    // 否则相邻格子有别的光源，放进添加队列，之后从它重新填充
+    // 最多处理 maxNodes 个格子，剩下的下次继续；队列处理完时清空
+    void unpropagate(LightChannel channel, size_t maxNodes = SIZE_MAX) {
+        std::vector<Node>& queue = m_remove[channel];
+        size_t& head = m_removeHead[channel];
+        for (size_t processed = 0; head < queue.size() && processed < maxNodes; head++, processed++) {
+            Node node = queue[head];
+            for (int d = 0; d < 6; d++) {
+                int nx = node.x + DIRECTIONS[d][0];
+                int ny = node.y + DIRECTIONS[d][1];
+                int nz = node.z + DIRECTIONS[d][2];
+                if (ny < 0 || ny >= Chunk::WORLD_HEIGHT) {
+                    continue;
+                }
+                Chunk* neighbor = chunkAt(nx, nz);
+                if (neighbor == nullptr) {
+                    continue;
+                }
+                int neighborLevel = level(neighbor, nx, ny, nz, channel);
+                if (neighborLevel == 0) {
+                    continue;
+                }
+                bool dependent = neighborLevel < node.level ||
+                                 (channel == LIGHT_SKY && d == DOWN && node.level == MAX_LIGHT && neighborLevel == MAX_LIGHT);
+                if (!dependent) {
+                    m_add[channel].push_back({nx, ny, nz, neighborLevel});
+                    continue;
+                }
+                setLevel(neighbor, nx, ny, nz, channel, 0);
+                queue.push_back({nx, ny, nz, neighborLevel});
+                // 被清掉的格子本身是光源时保留它自己的光，之后重新填充
+                int emission = (channel == LIGHT_BLOCK) ?
+                    blockLightEmission(neighbor->getBlock(nx & (Chunk::CHUNK_SIZE - 1), ny, nz & (Chunk::CHUNK_SIZE - 1))) : 0;
+                if (emission > 0) {
+                    setLevel(neighbor, nx, ny, nz, channel, emission);
+                    m_add[channel].push_back({nx, ny, nz, emission});
+                }
+            }
+        }
+        if (head == queue.size()) {
+            queue.clear();
+            head = 0;
+        }
+    }
+
+    ChunkMap* m_chunks;
+    Chunk* m_only;
+    Chunk* m_cachedChunk;
+    int m_cachedX, m_cachedZ;
+    bool m_hasCached;
+    std::vector<Node> m_add[2];              // 按 LightChannel 分开的添加队列，m_addHead 之前的已经处理
+    std::vector<Node> m_remove[2];           // 移除队列，同上
+    size_t m_addHead[2];
+    size_t m_removeHead[2];
+    std::vector<uint64_t> m_pendingBorders;  // 等待 seedBorders 的区块（ChunkMap::packKey）
+    std::vector<Chunk*> m_touched;           // 光照变化影响到网格的区块，process 结束时交给调用者
+    size_t m_changed;                        // 改变过的格子数
+};
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef LIGHT_STORAGE_H
+#define LIGHT_STORAGE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+// 16^3 的光照存储：每格一个字节，高 4 位为天空光、低 4 位为方块光（0 ~ 15）
+// 与 BlockStorage 一样，整段同一个值时只存这个值（地表以上全是 15 级天空光、地下深处全黑），
+// 第一次写入不同的值时才分配 4KB 的数组
+// 与 BlockStorage 一样复制时共享数组（写时复制），网格快照只增加引用计数
+class LightStorage {
+public:
+    static const int SIZE = 16;
+    static const int VOLUME = SIZE * SIZE * SIZE;
+
+    static const uint8_t FULL_SKY = 0xF0;   // 天空光 15，方块光 0
+
+    explicit LightStorage(uint8_t fillValue = FULL_SKY) : m_uniform(fillValue) {}
+
+    // 下标布局与 BlockStorage::index 一致
+    static int index(int x, int y, int z) {
+        return (x * SIZE + y) * SIZE + z;
+    }
+
+    static uint8_t pack(int sky, int block) {
+        return (uint8_t)((sky << 4) | block);
+    }
+    static int skyOf(uint8_t light) { return light >> 4; }
+    static int blockOf(uint8_t light) { return light & 0x0F; }
+
+    uint8_t get(int x, int y, int z) const {
+        return getIndex(index(x, y, z));
+    }
+
+    uint8_t getIndex(int i) const {
+        return (m_data != nullptr) ? m_data[i] : m_uniform;
+    }
+
+    void set(int x, int y, int z, uint8_t value) {
+        setIndex(index(x, y, z), value);
+    }
+
+    void setIndex(int i, uint8_t value) {
+        if (m_data == nullptr) {
+            if (value == m_uniform) {
+                return;
+            }
+            m_data.reset(new uint8_t[VOLUME]);
+            std::memset(m_data.get(), m_uniform, VOLUME);
+        } else if (m_data[i] == value) {
+            return;
+        } else if (m_data.use_count() > 1) {
+            // 与快照共享：复制一份再改
+            std::shared_ptr<uint8_t[]> copy(new uint8_t[VOLUME]);
+            std::memcpy(copy.get(), m_data.get(), VOLUME);
+            m_data = std::move(copy);
+        } else {
+            std::atomic_thread_fence(std::memory_order_acquire);   // 同 BlockStorage::mutableData
+        }
+        m_data[i] = value;
+    }
+
+    void fill(uint8_t value) {
+        m_data.reset();
+        m_uniform = value;
+    }
+
+    // 一次性写入整段（下标布局同 index()）；全部相同时不分配数组
+    void assign(const uint8_t* dense) {
+        for (int i = 1; i < VOLUME; i++) {
+            if (dense[i] != dense[0]) {
+                if (m_data == nullptr || m_data.use_count() > 1) {
+                    m_data.reset(new uint8_t[VOLUME]);
+                } else {
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                }
+                std::memcpy(m_data.get(), dense, VOLUME);
+                return;
+            }
+        }
+        fill(dense[0]);
+    }
+
+    // 展开为稠密数组（下标布局同 index()）
+    void copyTo(uint8_t* dense) const {
+        if (m_data == nullptr) {
+            std::memset(dense, m_uniform, VOLUME);
+        } else {
+            std::memcpy(dense, m_data.get(), VOLUME);
+        }
+    }
+
+    bool isUniform() const { return m_data == nullptr; }
+    uint8_t uniformValue() const { return m_uniform; }   // 只在 isUniform() 时有意义
+
+    // 如果整段已经是同一个值，释放数组
+    void compact() {
+        if (m_data == nullptr) {
+            return;
+        }
+        for (int i = 1; i < VOLUME; i++) {
+            if (m_data[i] != m_data[0]) {
+                return;
+            }
+        }
+        fill(m_data[0]);
+    }
+
+    // 占用的堆内存
+    size_t memoryUsage() const {
+        return (m_data != nullptr) ? VOLUME : 0;
+    }
+
+private:
+    std::shared_ptr<uint8_t[]> m_data;   // nullptr 表示整段都是 m_uniform；可能与快照共享
+    uint8_t m_uniform;
+};
+
+#endif
@@ -0,0 +1,239 @@
+#ifndef MESH_ARENA_H
+#define MESH_ARENA_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <vector>
+
+// 所有区块网格共用的顶点缓冲（mega-buffer）：
+// 一个大 VBO 按页（PAGE_VERTICES 个顶点）划分，用空闲链表（按起始页排序、释放时合并相邻空闲段）
+// 为每个区块分配连续的页；每页所属区块的世界坐标原点存放在一个纹理缓冲（TBO）里，
+// 顶点着色器用 gl_VertexID / PAGE_VERTICES 查到原点，因此不再需要逐区块的 model 矩阵，
+// 所有可见区块可以用一次 glMultiDrawArrays 绘制
+class MeshArena {
+public:
+    // 每页的顶点数，必须与 shader.vs 中的 PAGE_VERTICES 一致
+    static const int PAGE_VERTICES = 256;
+
+    // 一个区块网格在缓冲中的位置
+    struct Allocation {
+        int firstPage = -1;
+        int pageCount = 0;
+        int vertexCount = 0;
+
+        bool valid() const { return firstPage >= 0; }
+    };
+
+    MeshArena()
+        : m_vao(0), m_vbo(0), m_originBuffer(0), m_originTexture(0), m_capacityPages(0), m_usedPages(0),
+          m_uploads(0), m_uploadsInPlace(0) {}
+
+    MeshArena(const MeshArena&) = delete;
+    MeshArena& operator=(const MeshArena&) = delete;
+
+    // 创建 OpenGL 对象（需要有效的 OpenGL 上下文）
+    void init(int initialPages = 4096) {
+        glGenVertexArrays(1, &m_vao);
+        glGenBuffers(1, &m_originBuffer);
+        glGenTextures(1, &m_originTexture);
+
+        m_capacityPages = 0;
+        m_usedPages = 0;
+        m_freeRanges.clear();
+        grow(initialPages);
+    }
+
+    // 释放 OpenGL 对象（在销毁上下文之前调用）
+    void destroy() {
+        if (m_vao != 0) {
+            glDeleteVertexArrays(1, &m_vao);
+            glDeleteBuffers(1, &m_vbo);
+            glDeleteBuffers(1, &m_originBuffer);
+            glDeleteTextures(1, &m_originTexture);
+            m_vao = m_vbo = m_originBuffer = m_originTexture = 0;
+        }
+    }
+
+    // 上传一个区块的网格（重建后再次上传时 alloc 为旧的分配）
+    // 新网格放得下旧的页时原地覆盖并归还多出来的页，页原点不变、不用重新写；否则释放旧的分配再分配新页
+    // 两种情况都只用 glBufferSubData 写入已有的缓冲，不重新分配缓冲存储（只有 grow 扩容时才会）
+    void upload(Allocation& alloc, const std::vector<uint32_t>& vertices, const glm::vec3& origin) {
+        if (vertices.empty()) {
+            release(alloc);
+            return;
+        }
+
+        int pages = ((int)vertices.size() + PAGE_VERTICES - 1) / PAGE_VERTICES;
+        glm::vec4 pageOrigin(origin, 0.0f);
+        int firstPage;
+        bool inPlace = alloc.valid() && pages <= alloc.pageCount && m_pageOrigins[alloc.firstPage] == pageOrigin;
+        if (inPlace) {
+            firstPage = alloc.firstPage;
+            if (pages < alloc.pageCount) {
+                freePages(firstPage + pages, alloc.pageCount - pages);
+            }
+            m_uploadsInPlace++;
+        } else {
+            release(alloc);
+            firstPage = allocatePages(pages);
+        }
+        m_uploads++;
+
+        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+        glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)firstPage * PAGE_VERTICES * sizeof(uint32_t),
+                        vertices.size() * sizeof(uint32_t), vertices.data());
+
+        if (!inPlace) {
+            for (int i = 0; i < pages; i++) {
+                m_pageOrigins[firstPage + i] = pageOrigin;
+            }
+            glBindBuffer(GL_TEXTURE_BUFFER, m_originBuffer);
+            glBufferSubData(GL_TEXTURE_BUFFER, (GLintptr)firstPage * sizeof(glm::vec4),
+                            pages * sizeof(glm::vec4), &m_pageOrigins[firstPage]);
+            glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        }
+
+        alloc.firstPage = firstPage;
+        alloc.pageCount = pages;
+        alloc.vertexCount = (int)vertices.size();
+    }
+
+    // 归还一个区块占用的页
+    void release(Allocation& alloc) {
+        if (!alloc.valid()) {
+            return;
+        }
+        freePages(alloc.firstPage, alloc.pageCount);
+        alloc = Allocation();
+    }
+
+    // 每帧：清空绘制列表，逐个加入可见区块，最后一次性绘制
+    void beginFrame() {
+        m_drawFirsts.clear();
+        m_drawCounts.clear();
+    }
+
+    void addDraw(const Allocation& alloc) {
+        if (alloc.valid() && alloc.vertexCount > 0) {
+            m_drawFirsts.push_back(alloc.firstPage * PAGE_VERTICES);
+            m_drawCounts.push_back(alloc.vertexCount);
+        }
+    }
+
+    // 绑定页原点纹理到指定纹理单元并绘制列表中的全部区块
+    void draw(int originTextureUnit) {
+        if (m_drawFirsts.empty()) {
+            return;
+        }
+        glActiveTexture(GL_TEXTURE0 + originTextureUnit);
+        glBindTexture(GL_TEXTURE_BUFFER, m_originTexture);
+
+        glBindVertexArray(m_vao);
+        glMultiDrawArrays(GL_TRIANGLES, m_drawFirsts.data(), m_drawCounts.data(), (GLsizei)m_drawFirsts.size());
+        glBindVertexArray(0);
+    }
+
+    int drawCount() const { return (int)m_drawFirsts.size(); }
+    int capacityPages() const { return m_capacityPages; }
+    int usedPages() const { return m_usedPages; }
+    size_t uploads() const { return m_uploads; }
+    size_t uploadsInPlace() const { return m_uploadsInPlace; }   // 写回原来的页、没有重新分配的上传
+
+private:
+    // 首次适配：找第一个足够大的空闲段；没有则扩容
+    int allocatePages(int pages) {
+        for (auto it = m_freeRanges.begin(); it != m_freeRanges.end(); ++it) {
+            if (it->second >= pages) {
+                int first = it->first;
+                int remaining = it->second - pages;
+                m_freeRanges.erase(it);
+                if (remaining > 0) {
+                    m_freeRanges[first + pages] = remaining;
+                }
+                m_usedPages += pages;
+                return first;
+            }
+        }
+
+        grow(m_capacityPages + ((pages > m_capacityPages) ? pages : m_capacityPages));
+        return allocatePages(pages);
+    }
+
+    void freePages(int first, int pages) {
+        m_usedPages -= pages;
+        addFreeRange(first, pages);
+    }
+
+    // 加入空闲段，并与前后相邻的空闲段合并
+    void addFreeRange(int first, int pages) {
+        auto next = m_freeRanges.lower_bound(first);
+        if (next != m_freeRanges.end() && first + pages == next->first) {
+            pages += next->second;
+            next = m_freeRanges.erase(next);
+        }
+        if (next != m_freeRanges.begin()) {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == first) {
+                prev->second += pages;
+                return;
+            }
+        }
+        m_freeRanges[first] = pages;
+    }
+
+    // 扩容：新建更大的缓冲，把旧内容在 GPU 上复制过去
+    void grow(int newCapacityPages) {
+        GLsizeiptr newBytes = (GLsizeiptr)newCapacityPages * PAGE_VERTICES * sizeof(uint32_t);
+        GLsizeiptr oldBytes = (GLsizeiptr)m_capacityPages * PAGE_VERTICES * sizeof(uint32_t);
+
+        unsigned int newVbo;
+        glGenBuffers(1, &newVbo);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, newVbo);
+        glBufferData(GL_COPY_WRITE_BUFFER, newBytes, nullptr, GL_DYNAMIC_DRAW);
+        if (oldBytes > 0) {
+            glBindBuffer(GL_COPY_READ_BUFFER, m_vbo);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldBytes);
+        }
+        if (m_vbo != 0) {
+            glDeleteBuffers(1, &m_vbo);
+        }
+        m_vbo = newVbo;
+
+        // 打包的顶点数据 (1 uint)，用整数属性传入，由顶点着色器解包
+        glBindVertexArray(m_vao);
+        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+        glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(uint32_t), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindVertexArray(0);
+
+        // 页原点：CPU 端保留一份，扩容时整体重新上传
+        m_pageOrigins.resize(newCapacityPages, glm::vec4(0.0f));
+        glBindBuffer(GL_TEXTURE_BUFFER, m_originBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, m_pageOrigins.size() * sizeof(glm::vec4), m_pageOrigins.data(), GL_DYNAMIC_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, m_originTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_originBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+        addFreeRange(m_capacityPages, newCapacityPages - m_capacityPages);
+        m_capacityPages = newCapacityPages;
+    }
+
+    unsigned int m_vao, m_vbo;
+    unsigned int m_originBuffer, m_originTexture;
+
+    int m_capacityPages;
+    int m_usedPages;
+    std::map<int, int> m_freeRanges;        // 起始页 -> 页数
+    std::vector<glm::vec4> m_pageOrigins;   // 每页所属区块的世界坐标原点
+    size_t m_uploads;
+    size_t m_uploadsInPlace;
+
+    std::vector<GLint> m_drawFirsts;
+    std::vector<GLsizei> m_drawCounts;
+};
+
+#endif
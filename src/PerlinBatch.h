@@ -0,0 +1,29 @@
+#ifndef PERLIN_BATCH_H
+#define PERLIN_BATCH_H
+
+// 批量计算 fBm 柏林噪声：一次处理多个采样点（地形生成时一个区块的 256 列）
+// 结果与逐点调用 stb_perlin_fbm_noise3 一致（同样的置换表、梯度和运算顺序）
+// 实现在 stb_perlin.cpp 中，因为需要直接使用 stb_perlin 内部的 static 置换表
+
+// 计算后端：AVX2 一次 8 个点（硬件 gather），SSE2 一次 4 个点，标量逐点调用 stb
+enum NoiseBackend {
+    NOISE_SCALAR,
+    NOISE_SSE2,
+    NOISE_AVX2
+};
+
+// 默认后端（首次调用时检测）：有 AVX2 时用 AVX2，否则用标量（SSE2 不一定比标量快，只在显式指定时使用）
+NoiseBackend perlinBestBackend();
+
+// 后端是否可用（标量总是可用）
+bool perlinBackendSupported(NoiseBackend backend);
+
+const char* perlinBackendName(NoiseBackend backend);
+
+// out[i] = stb_perlin_fbm_noise3(x[i], y[i], z[i], lacunarity, gain, octaves)，i = 0 ~ count-1
+// 不足一组向量宽度的尾部用标量计算；backend 不受支持时退回标量
+void perlinFbmNoise3Batch(const float* x, const float* y, const float* z, float* out, int count,
+                          float lacunarity, float gain, int octaves,
+                          NoiseBackend backend = perlinBestBackend());
+
+#endif
@@ -2,8 +2,11 @@
 #define PLAYER_H
 
 #include <glm/glm.hpp>
+#include <cmath>
+#include <cstddef>
 #include "Chunk.h"
-#include <map>
+#include "ChunkMap.h"
+#include "Profiler.h"
 
 // AABB 包围盒结构
 struct AABB {
@@ -41,10 +44,16 @@ public:
     static constexpr float JUMP_STRENGTH = 8.0f;  // 跳跃力度
     static constexpr float TERMINAL_VELOCITY = -50.0f; // 最大下落速度
     
+    // 浮点误差容差：贴着方块表面（误差在此范围内）不算进入该方块
+    static constexpr float CONTACT_EPSILON = 1e-4f;
+    
     bool onGround;  // 是否在地面上
+
+    // 统计：碰撞检测查询方块的次数（性能测试用）
+    size_t blockLookups;
     
     Player(glm::vec3 startPos) 
-        : position(startPos), velocity(0.0f), onGround(false) {}
+        : position(startPos), velocity(0.0f), onGround(false), blockLookups(0) {}
     
     // 获取玩家的AABB包围盒
     AABB getAABB() const {
@@ -57,7 +66,9 @@ public:
     }
     
     // 检查指定位置的方块是否为实心（非空气）
-    bool isBlockSolid(int x, int y, int z, std::map<std::pair<int, int>, Chunk*>& chunks) {
+    bool isBlockSolid(int x, int y, int z, ChunkMap& chunks) {
+        blockLookups++;
+
         // 计算方块所在的区块坐标
         int chunkX = (x >= 0) ? x / 16 : (x - 15) / 16;
         int chunkZ = (z >= 0) ? z / 16 : (z - 15) / 16;
@@ -66,27 +77,25 @@ public:
         int localX = x - chunkX * 16;
         int localZ = z - chunkZ * 16;
         
-        // 查找对应的区块
-        auto it = chunks.find({chunkX, chunkZ});
-        if (it == chunks.end()) {
+        // 查找对应的区块（连续查询通常命中 ChunkMap 的上次命中缓存）
+        Chunk* chunk = chunks.find(chunkX, chunkZ);
+        if (chunk == nullptr) {
             return false; // 区块不存在，视为空气
         }
         
-        Chunk* chunk = it->second;
-        
         // 检查坐标是否在区块范围内
         if (localX < 0 || localX >= 16 || 
-            y < 0 || y >= 16 || 
+            y < 0 || y >= Chunk::WORLD_HEIGHT || 
             localZ < 0 || localZ >= 16) {
             return false;
         }
         
         // 返回该方块是否为实心
-        return chunk->m_blocks[localX][y][localZ] != BLOCK_AIR;
+        return chunk->getBlock(localX, y, localZ) != BLOCK_AIR;
     }
     
     // 检测玩家与世界的碰撞
-    bool checkCollision(glm::vec3 newPos, std::map<std::pair<int, int>, Chunk*>& chunks) {
+    bool checkCollision(glm::vec3 newPos, ChunkMap& chunks) {
         AABB playerBox(newPos, WIDTH, HEIGHT, DEPTH);
         
         // 检查玩家包围盒与周围方块的碰撞
@@ -117,8 +126,57 @@ public:
         return false; // 没有碰撞
     }
     
-    // 物理更新
-    void update(float deltaTime, std::map<std::pair<int, int>, Chunk*>& chunks) {
+    // 沿一个轴（0=x, 1=y, 2=z）扫掠包围盒，返回不穿过实心方块时能移动的距离
+    // 只检查前进方向上新进入的方块层：每层是包围盒在另外两个轴上覆盖的方块（横截面），
+    // 由近到远逐层检查，遇到实心方块就停在它的表面上（精确贴合），后面的层不再查询
+    // 一帧移动多远都会逐层检查，不会穿过方块；没有跨过方块边界的移动不查询任何方块
+    float sweepAxis(const AABB& box, int axis, float delta, ChunkMap& chunks) {
+        if (delta == 0.0f) {
+            return 0.0f;
+        }
+        const int u = (axis + 1) % 3;
+        const int v = (axis + 2) % 3;
+
+        // 横截面覆盖的方块范围（贴着表面不算覆盖）
+        int uMin = (int)std::floor(box.min[u] + CONTACT_EPSILON);
+        int uMax = (int)std::ceil(box.max[u] - CONTACT_EPSILON) - 1;
+        int vMin = (int)std::floor(box.min[v] + CONTACT_EPSILON);
+        int vMax = (int)std::ceil(box.max[v] - CONTACT_EPSILON) - 1;
+
+        // 前进方向上第一层和最后一层方块
+        int first, last, step;
+        if (delta > 0.0f) {
+            first = (int)std::ceil(box.max[axis] - CONTACT_EPSILON);
+            last = (int)std::ceil(box.max[axis] + delta) - 1;
+            step = 1;
+        } else {
+            first = (int)std::floor(box.min[axis] + CONTACT_EPSILON) - 1;
+            last = (int)std::floor(box.min[axis] + delta);
+            step = -1;
+        }
+
+        int cell[3];
+        for (int layer = first; (step > 0) ? layer <= last : layer >= last; layer += step) {
+            cell[axis] = layer;
+            for (int a = uMin; a <= uMax; a++) {
+                cell[u] = a;
+                for (int b = vMin; b <= vMax; b++) {
+                    cell[v] = b;
+                    if (isBlockSolid(cell[0], cell[1], cell[2], chunks)) {
+                        // 停在这一层方块的表面
+                        return (step > 0) ? (float)layer - box.max[axis]
+                                          : (float)(layer + 1) - box.min[axis];
+                    }
+                }
+            }
+        }
+        return delta;
+    }
+
+    // 物理更新：扫掠 AABB 连续碰撞检测，依次处理 y、x、z 轴
+    // 每个轴精确移动到接触面，被挡住的轴速度清零，其余轴继续移动（沿表面滑动）
+    void update(float deltaTime, ChunkMap& chunks) {
+        PROFILE_ZONE("Player::update");
         // 应用重力
         velocity.y += GRAVITY * deltaTime;
         
@@ -126,40 +184,19 @@ public:
         if (velocity.y < TERMINAL_VELOCITY) {
             velocity.y = TERMINAL_VELOCITY;
         }
-        
-        // 保存旧位置
-        glm::vec3 oldPosition = position;
-        
-        // 分别处理每个轴的移动（避免卡在墙角）
-        // X轴移动
-        glm::vec3 newPos = position;
-        newPos.x += velocity.x * deltaTime;
-        if (!checkCollision(newPos, chunks)) {
-            position.x = newPos.x;
-        } else {
-            velocity.x = 0;
-        }
-        
-        // Y轴移动（重力）
-        newPos = position;
-        newPos.y += velocity.y * deltaTime;
-        if (!checkCollision(newPos, chunks)) {
-            position.y = newPos.y;
-            onGround = false;
-        } else {
-            if (velocity.y < 0) {
-                onGround = true; // 落在地面上
+
+        static const int AXIS_ORDER[3] = {1, 0, 2};
+        onGround = false;
+        for (int axis : AXIS_ORDER) {
+            float delta = velocity[axis] * deltaTime;
+            float moved = sweepAxis(getAABB(), axis, delta, chunks);
+            position[axis] += moved;
+            if (moved != delta) {
+                if (axis == 1 && velocity.y < 0.0f) {
+                    onGround = true; // 落在地面上
+                }
+                velocity[axis] = 0.0f;
             }
-            velocity.y = 0;
-        }
-        
-        // Z轴移动
-        newPos = position;
-        newPos.z += velocity.z * deltaTime;
-        if (!checkCollision(newPos, chunks)) {
-            position.z = newPos.z;
-        } else {
-            velocity.z = 0;
         }
     }
     
@@ -0,0 +1,121 @@
+#ifndef RAYCAST_H
+#define RAYCAST_H
+
+#include <glm/glm.hpp>
+#include <cmath>
+#include <cstdint>
+#include "Chunk.h"
+#include "ChunkMap.h"
+
+// 射线检测结果
+struct RaycastHit {
+    bool hit = false;
+    glm::ivec3 block = glm::ivec3(0);    // 命中方块的世界坐标
+    glm::ivec3 normal = glm::ivec3(0);   // 命中面的法线（起点在方块内部时为 0）；放置方块的位置 = block + normal
+    float distance = 0.0f;               // 从起点到命中面的距离
+    uint16_t blockType = BLOCK_AIR;
+};
+
+// 体素射线检测（Amanatides-Woo 网格遍历）：沿射线逐个经过的方块前进，直到遇到实心方块或超出最大距离
+// 当前区块和段的指针随射线移动更新：跨过区块边界时走 Chunk::m_neighbors，只有从未加载区域进入时才查 ChunkMap；
+// 段指针只在区块或段变化时重新获取，全空气（未分配）的段直接跳过
+// 未加载的区块和世界上下边界之外视为空气
+inline RaycastHit raycastBlocks(const ChunkMap& chunks, const glm::vec3& origin, const glm::vec3& direction,
+                                float maxDistance) {
+    RaycastHit result;
+    float length = glm::length(direction);
+    if (length == 0.0f) {
+        return result;
+    }
+    const glm::vec3 dir = direction / length;   // 单位方向，t 即为距离
+    const float INF = 1e30f;
+    const int N = Chunk::CHUNK_SIZE;
+
+    glm::ivec3 cell((int)std::floor(origin.x), (int)std::floor(origin.y), (int)std::floor(origin.z));
+    glm::ivec3 step(0);
+    glm::vec3 tMax(INF);     // 沿各轴到达下一个方块边界时的 t
+    glm::vec3 tDelta(INF);   // 沿各轴穿过一整格所需的 t
+    for (int i = 0; i < 3; i++) {
+        if (dir[i] > 0.0f) {
+            step[i] = 1;
+            tDelta[i] = 1.0f / dir[i];
+            tMax[i] = ((float)cell[i] + 1.0f - origin[i]) * tDelta[i];
+        } else if (dir[i] < 0.0f) {
+            step[i] = -1;
+            tDelta[i] = -1.0f / dir[i];
+            tMax[i] = (origin[i] - (float)cell[i]) * tDelta[i];
+        }
+    }
+
+    int chunkX = (cell.x >= 0) ? cell.x / N : (cell.x - N + 1) / N;
+    int chunkZ = (cell.z >= 0) ? cell.z / N : (cell.z - N + 1) / N;
+    int localX = cell.x - chunkX * N;
+    int localZ = cell.z - chunkZ * N;
+    const Chunk* chunk = chunks.find(chunkX, chunkZ);
+
+    // 当前段：sectionIndex 为 cell.y 所在段（世界上下边界外为 -1），section 为空表示全空气或区块未加载
+    auto sectionOf = [](int y) { return (y >= 0 && y < Chunk::WORLD_HEIGHT) ? y / N : -1; };
+    int sectionIndex = sectionOf(cell.y);
+    const ChunkSection* section = (chunk != nullptr && sectionIndex >= 0) ? chunk->getSection(sectionIndex) : nullptr;
+
+    float t = 0.0f;
+    glm::ivec3 normal(0);
+    while (true) {
+        if (section != nullptr) {
+            uint16_t blockType = section->blocks.get(localX, cell.y - sectionIndex * N, localZ);
+            if (blockType != BLOCK_AIR) {
+                result.hit = true;
+                result.block = cell;
+                result.normal = normal;
+                result.distance = t;
+                result.blockType = blockType;
+                return result;
+            }
+        }
+
+        // 沿最先到达边界的轴前进一格
+        int axis = (tMax.x < tMax.y) ? ((tMax.x < tMax.z) ? 0 : 2) : ((tMax.y < tMax.z) ? 1 : 2);
+        t = tMax[axis];
+        if (t > maxDistance) {
+            return result;
+        }
+        cell[axis] += step[axis];
+        tMax[axis] += tDelta[axis];
+        normal = glm::ivec3(0);
+        normal[axis] = -step[axis];
+
+        if (axis == 1) {
+            // 射线已离开世界上下边界且不会再回来
+            if ((cell.y < 0 && step.y < 0) || (cell.y >= Chunk::WORLD_HEIGHT && step.y > 0)) {
+                return result;
+            }
+            int newSection = sectionOf(cell.y);
+            if (newSection == sectionIndex) {
+                continue;
+            }
+            sectionIndex = newSection;
+        } else if (axis == 0) {
+            localX += step.x;
+            if (localX >= 0 && localX < N) {
+                continue;
+            }
+            chunkX += step.x;
+            localX -= step.x * N;
+            chunk = (chunk != nullptr) ? chunk->m_neighbors[(step.x < 0) ? NEIGHBOR_NEG_X : NEIGHBOR_POS_X]
+                                       : chunks.find(chunkX, chunkZ);
+        } else {
+            localZ += step.z;
+            if (localZ >= 0 && localZ < N) {
+                continue;
+            }
+            chunkZ += step.z;
+            localZ -= step.z * N;
+            chunk = (chunk != nullptr) ? chunk->m_neighbors[(step.z < 0) ? NEIGHBOR_NEG_Z : NEIGHBOR_POS_Z]
+                                       : chunks.find(chunkX, chunkZ);
+        }
+        // 进入了新的区块或段
+        section = (chunk != nullptr && sectionIndex >= 0) ? chunk->getSection(sectionIndex) : nullptr;
+    }
+}
+
+#endif
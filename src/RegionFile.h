@@ -0,0 +1,340 @@
+#ifndef REGION_FILE_H
+#define REGION_FILE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// 区域文件：一个文件保存 32x32 个区块，按 4KB 扇区分配
+// - 第 0 个扇区是偏移表：1024 项 uint32，高 24 位为起始扇区号，低 8 位为占用扇区数（0 表示没有存档）
+// - 每个区块的数据从扇区边界开始：uint32 数据长度 + 数据，不足一个扇区的部分补 0
+// 保存时总是写到空闲扇区（第一段足够长的连续空间，都没有就追加到文件末尾），从不覆盖区块当前的数据；
+// 数据写完后才改偏移表，所以进程在写入中途崩溃时偏移表仍指向完整的旧数据
+// 被替换（或删除）的旧扇区要等下一次 flush(true) 的 fsync 完成后才能再分配：之前的偏移表可能还没落盘，
+// 断电时磁盘上的偏移表仍可能指向它们。断电只会影响上次 fsync 之后保存的区块（偏移表与新数据的落盘顺序不定），
+// 在那之前落盘的区块不会被破坏
+// 只有被保存的区块才会写盘，其他区块的扇区不动；write/erase 不刷新，由调用方在一批写入后 flush
+// 数值按本机字节序（小端）存储
+// 不是线程安全的，由 WorldStorage 加锁
+class RegionFile {
+public:
+    static const int REGION_SIZE = 32;                          // 每个区域文件 32x32 个区块
+    static const int CHUNK_COUNT = REGION_SIZE * REGION_SIZE;
+    static const int SECTOR_SIZE = 4096;
+    static const int MAX_CHUNK_SECTORS = 255;                   // 偏移表中扇区数只有 8 位
+
+    RegionFile() : m_file(nullptr), m_unflushed(false) {
+        std::memset(m_offsets, 0, sizeof(m_offsets));
+    }
+
+    ~RegionFile() {
+        close();
+    }
+
+    RegionFile(const RegionFile&) = delete;
+    RegionFile& operator=(const RegionFile&) = delete;
+
+    // 打开区域文件；不存在时 create 为 true 则创建（只写入空的偏移表），否则返回 false
+    bool open(const std::string& path, bool create = true) {
+        close();
+        m_file = std::fopen(path.c_str(), "r+b");
+        if (m_file == nullptr) {
+            if (!create) {
+                return false;
+            }
+            m_file = std::fopen(path.c_str(), "w+b");
+            if (m_file == nullptr) {
+                return false;
+            }
+            if (std::fwrite(m_offsets, sizeof(m_offsets), 1, m_file) != 1) {
+                close();
+                return false;
+            }
+            std::fflush(m_file);
+        } else if (std::fread(m_offsets, sizeof(m_offsets), 1, m_file) != 1) {
+            close();
+            return false;
+        }
+
+        // 根据偏移表重建扇区占用表（第 0 个扇区是偏移表本身）
+        std::fseek(m_file, 0, SEEK_END);
+        long fileSize = std::ftell(m_file);
+        m_usedSectors.assign((size_t)(fileSize + SECTOR_SIZE - 1) / SECTOR_SIZE, false);
+        m_usedSectors[0] = true;
+        m_pendingFree.clear();
+        for (int i = 0; i < CHUNK_COUNT; i++) {
+            uint32_t start = m_offsets[i] >> 8;
+            uint32_t count = m_offsets[i] & 0xFF;
+            if (count == 0 || start == 0 || start + count > m_usedSectors.size()) {
+                m_offsets[i] = 0;   // 损坏或被截断的项当作没有存档
+                continue;
+            }
+            markSectors(start, count, true);
+        }
+        return true;
+    }
+
+    void close() {
+        if (m_file != nullptr) {
+            flush(true);
+            std::fclose(m_file);
+            m_file = nullptr;
+        }
+    }
+
+    bool isOpen() const { return m_file != nullptr; }
+
+    // 区域内坐标 0 ~ REGION_SIZE-1
+    bool hasChunk(int localX, int localZ) const {
+        return m_offsets[localIndex(localX, localZ)] != 0;
+    }
+
+    // 读取一个区块的数据；没有存档或读取失败时返回 false
+    bool read(int localX, int localZ, std::vector<uint8_t>& out) {
+        uint32_t entry = m_offsets[localIndex(localX, localZ)];
+        if (entry == 0 || m_file == nullptr) {
+            return false;
+        }
+        uint32_t start = entry >> 8;
+        uint32_t count = entry & 0xFF;
+        uint32_t length = 0;
+        if (std::fseek(m_file, (long)start * SECTOR_SIZE, SEEK_SET) != 0 ||
+            std::fread(&length, sizeof(length), 1, m_file) != 1 ||
+            length > count * SECTOR_SIZE - sizeof(length)) {
+            return false;
+        }
+        out.resize(length);
+        return length == 0 || std::fread(out.data(), length, 1, m_file) == 1;
+    }
+
+    // 写入一个区块的数据；返回是否成功（数据超过 MAX_CHUNK_SECTORS 个扇区时失败）
+    bool write(int localX, int localZ, const uint8_t* data, size_t size) {
+        if (m_file == nullptr) {
+            return false;
+        }
+        uint32_t needed = (uint32_t)((sizeof(uint32_t) + size + SECTOR_SIZE - 1) / SECTOR_SIZE);
+        if (needed > MAX_CHUNK_SECTORS) {
+            return false;
+        }
+        int index = localIndex(localX, localZ);
+        uint32_t oldStart = m_offsets[index] >> 8;
+        uint32_t oldCount = m_offsets[index] & 0xFF;
+
+        // 旧数据的扇区仍标记为占用，新数据一定写在别处
+        uint32_t start = findFreeSectors(needed);
+        if (start + needed > m_usedSectors.size()) {
+            m_usedSectors.resize(start + needed, false);
+        }
+
+        m_buffer.assign((size_t)needed * SECTOR_SIZE, 0);
+        uint32_t length = (uint32_t)size;
+        std::memcpy(m_buffer.data(), &length, sizeof(length));
+        if (size > 0) {
+            std::memcpy(m_buffer.data() + sizeof(length), data, size);
+        }
+        if (std::fseek(m_file, (long)start * SECTOR_SIZE, SEEK_SET) != 0 ||
+            std::fwrite(m_buffer.data(), m_buffer.size(), 1, m_file) != 1) {
+            return false;
+        }
+
+        uint32_t entry = (start << 8) | needed;
+        if (std::fseek(m_file, (long)index * sizeof(uint32_t), SEEK_SET) != 0 ||
+            std::fwrite(&entry, sizeof(entry), 1, m_file) != 1) {
+            return false;
+        }
+        m_unflushed = true;
+
+        if (oldCount != 0) {
+            m_pendingFree.push_back({oldStart, oldCount});
+        }
+        markSectors(start, needed, true);
+        m_offsets[index] = entry;
+        return true;
+    }
+
+    // 删除一个区块的存档：偏移表项清零，它占用的扇区在下一次 flush(true) 后归还
+    bool erase(int localX, int localZ) {
+        int index = localIndex(localX, localZ);
+        uint32_t entry = m_offsets[index];
+        if (entry == 0) {
+            return true;
+        }
+        uint32_t empty = 0;
+        if (m_file == nullptr ||
+            std::fseek(m_file, (long)index * sizeof(uint32_t), SEEK_SET) != 0 ||
+            std::fwrite(&empty, sizeof(empty), 1, m_file) != 1) {
+            return false;
+        }
+        m_unflushed = true;
+        m_pendingFree.push_back({entry >> 8, entry & 0xFF});
+        m_offsets[index] = 0;
+        return true;
+    }
+
+    // 把写入的数据交给操作系统；sync 为 true 时还等待数据落盘（fsync），返回是否真的做了 sync
+    // fsync 之后偏移表已经落盘，被替换的旧扇区才可以再分配
+    // write/erase 本身不刷新，连续写入多个区块后只需要刷新一次
+    bool flush(bool sync) {
+        if (m_file == nullptr || !m_unflushed) {
+            return false;
+        }
+        std::fflush(m_file);
+        if (!sync) {
+            return false;
+        }
+#ifdef _WIN32
+        bool synced = _commit(_fileno(m_file)) == 0;
+#else
+        bool synced = fsync(fileno(m_file)) == 0;
+#endif
+        if (synced) {
+            for (const SectorRange& range : m_pendingFree) {
+                markSectors(range.start, range.count, false);
+            }
+            m_pendingFree.clear();
+        }
+        m_unflushed = false;
+        return true;
+    }
+
+    // 文件占用的扇区数（含空闲扇区）和其中已使用的扇区数（含等待 fsync 后归还的扇区）
+    size_t sectorCount() const { return m_usedSectors.size(); }
+    size_t usedSectorCount() const {
+        size_t used = 0;
+        for (bool b : m_usedSectors) {
+            used += b ? 1 : 0;
+        }
+        return used;
+    }
+
+private:
+    struct SectorRange {
+        uint32_t start;
+        uint32_t count;
+    };
+
+    static int localIndex(int localX, int localZ) {
+        return localX + localZ * REGION_SIZE;
+    }
+
+    void markSectors(uint32_t start, uint32_t count, bool used) {
+        for (uint32_t i = start; i < start + count; i++) {
+            m_usedSectors[i] = used;
+        }
+    }
+
+    // 第一段至少 count 个连续的空闲扇区；没有时从文件末尾的空闲扇区（或文件末尾）开始向后扩展
+    uint32_t findFreeSectors(uint32_t count) const {
+        uint32_t run = 0;
+        for (uint32_t i = 1; i < m_usedSectors.size(); i++) {
+            run = m_usedSectors[i] ? 0 : run + 1;
+            if (run == count) {
+                return i + 1 - count;
+            }
+        }
+        return (uint32_t)m_usedSectors.size() - run;
+    }
+
+    std::FILE* m_file;
+    bool m_unflushed;                         // 有 write/erase 还没有 fsync
+    uint32_t m_offsets[CHUNK_COUNT];          // 偏移表（与文件第 0 个扇区一致）
+    std::vector<bool> m_usedSectors;          // 扇区是否被占用
+    std::vector<SectorRange> m_pendingFree;   // 被替换或删除、等下一次 fsync 后才归还的扇区
+    std::vector<uint8_t> m_buffer;            // 写入时按扇区对齐的临时缓冲
+};
+
+// 只读的区域文件映射：整个文件 mmap 到内存，区块数据直接从映射中解码，不复制到缓冲区
+// 依赖内核的页缓存：只有实际读到的扇区才会被读入，反复读取同一个世界时没有系统调用
+// 映射的是打开时的文件内容，之后文件被写入（尤其是变长）要重新映射（由 WorldStorage 负责）
+// Windows 上退回为一次性把整个文件读进内存
+class RegionMapping {
+public:
+    RegionMapping() : m_data(nullptr), m_size(0) {}
+
+    ~RegionMapping() {
+#ifndef _WIN32
+        if (m_data != nullptr) {
+            munmap((void*)m_data, m_size);
+        }
+#endif
+    }
+
+    RegionMapping(const RegionMapping&) = delete;
+    RegionMapping& operator=(const RegionMapping&) = delete;
+
+    // 文件不存在或不足一个偏移表时返回 false
+    bool open(const std::string& path) {
+#ifdef _WIN32
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (file == nullptr) {
+            return false;
+        }
+        std::fseek(file, 0, SEEK_END);
+        long fileSize = std::ftell(file);
+        std::fseek(file, 0, SEEK_SET);
+        if (fileSize >= RegionFile::SECTOR_SIZE) {
+            m_buffer.resize((size_t)fileSize);
+            if (std::fread(m_buffer.data(), m_buffer.size(), 1, file) != 1) {
+                m_buffer.clear();
+            }
+        }
+        std::fclose(file);
+        m_data = m_buffer.data();
+        m_size = m_buffer.size();
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size >= RegionFile::SECTOR_SIZE) {
+            void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (data != MAP_FAILED) {
+                m_data = (const uint8_t*)data;
+                m_size = (size_t)info.st_size;
+            }
+        }
+        ::close(fd);   // 映射在关闭文件后仍然有效
+#endif
+        return m_size >= (size_t)RegionFile::SECTOR_SIZE;
+    }
+
+    // 区块数据在映射中的位置（与 RegionFile::read 读到的内容相同）；没有存档或超出文件范围时返回 nullptr
+    const uint8_t* chunkData(int localX, int localZ, size_t& size) const {
+        uint32_t entry;
+        std::memcpy(&entry, m_data + (localX + localZ * RegionFile::REGION_SIZE) * sizeof(uint32_t), sizeof(entry));
+        size_t start = (size_t)(entry >> 8) * RegionFile::SECTOR_SIZE;
+        size_t count = entry & 0xFF;
+        uint32_t length = 0;
+        if (count == 0 || start == 0 || start + count * RegionFile::SECTOR_SIZE > m_size) {
+            return nullptr;
+        }
+        std::memcpy(&length, m_data + start, sizeof(length));
+        if (length > count * RegionFile::SECTOR_SIZE - sizeof(length)) {
+            return nullptr;
+        }
+        size = length;
+        return m_data + start + sizeof(length);
+    }
+
+    size_t size() const { return m_size; }
+
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+#ifdef _WIN32
+    std::vector<uint8_t> m_buffer;
+#endif
+};
+
+#endif
@@ -7,6 +7,9 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
 
 // 2. 定义类 (对应你的图2)
 class Shader
@@ -20,10 +23,29 @@ public:
     // 激活程序
     void use();
 
-    // Uniform 工具函数声明
+    // 查询 uniform 位置（来自链接时建立的缓存，不访问驱动）；不存在时返回 -1
+    // 每帧/每个区块都要设置的 uniform 应在初始化时取一次位置，之后用下面按位置设置的函数
+    int getUniformLocation(const std::string &name) const;
+
+    // Uniform 工具函数声明（按名字，经过缓存查找）
     void setBool(const std::string &name, bool value) const;
     void setInt(const std::string &name, int value) const;
     void setFloat(const std::string &name, float value) const;
+    void setVec3(const std::string &name, const glm::vec3 &value) const;
+    void setMat4(const std::string &name, const glm::mat4 &value) const;
+
+    // Uniform 工具函数声明（按预先取得的位置，无字符串查找）
+    void setBool(int location, bool value) const;
+    void setInt(int location, int value) const;
+    void setFloat(int location, float value) const;
+    void setVec3(int location, const glm::vec3 &value) const;
+    void setMat4(int location, const glm::mat4 &value) const;
+
+private:
+    // 链接后反射所有活动的 uniform，建立 名字 -> 位置 的缓存
+    void cacheUniforms();
+
+    std::unordered_map<std::string, int> m_uniformLocations;
 };
 
 // ------------------------------------------------------------------------
@@ -92,6 +114,41 @@ inline Shader::Shader(const char* vertexPath, const char* fragmentPath)
     // 删除着色器，它们已经链接到我们的程序中了，已经不再需要了
     glDeleteShader(vertex);
     glDeleteShader(fragment);
+
+    cacheUniforms();
+}
+
+inline void Shader::cacheUniforms()
+{
+    m_uniformLocations.clear();
+
+    int count = 0;
+    int maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::string name(maxLength > 0 ? maxLength : 1, '\0');
+
+    for (int i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(ID, (GLuint)i, (GLsizei)name.size(), &length, &size, &type, &name[0]);
+        std::string uniformName(name.data(), length);
+        int location = glGetUniformLocation(ID, uniformName.c_str());
+
+        // 数组 uniform 报告为 "name[0]"，同时以 "name" 缓存
+        m_uniformLocations[uniformName] = location;
+        size_t bracket = uniformName.find('[');
+        if (bracket != std::string::npos) {
+            m_uniformLocations[uniformName.substr(0, bracket)] = location;
+        }
+    }
+}
+
+inline int Shader::getUniformLocation(const std::string &name) const
+{
+    auto it = m_uniformLocations.find(name);
+    return (it != m_uniformLocations.end()) ? it->second : -1;
 }
 
 // 激活函数的实现
@@ -103,15 +160,44 @@ inline void Shader::use()
 // Uniform工具函数的实现
 inline void Shader::setBool(const std::string &name, bool value) const
 {         
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+    setBool(getUniformLocation(name), value);
 }
 inline void Shader::setInt(const std::string &name, int value) const
 { 
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+    setInt(getUniformLocation(name), value);
 }
 inline void Shader::setFloat(const std::string &name, float value) const
 { 
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+    setFloat(getUniformLocation(name), value);
+}
+inline void Shader::setVec3(const std::string &name, const glm::vec3 &value) const
+{ 
+    setVec3(getUniformLocation(name), value);
+}
+inline void Shader::setMat4(const std::string &name, const glm::mat4 &value) const
+{ 
+    setMat4(getUniformLocation(name), value);
+}
+
+inline void Shader::setBool(int location, bool value) const
+{         
+    glUniform1i(location, (int)value); 
+}
+inline void Shader::setInt(int location, int value) const
+{ 
+    glUniform1i(location, value); 
+}
+inline void Shader::setFloat(int location, float value) const
+{ 
+    glUniform1f(location, value); 
+}
+inline void Shader::setVec3(int location, const glm::vec3 &value) const
+{ 
+    glUniform3fv(location, 1, glm::value_ptr(value)); 
+}
+inline void Shader::setMat4(int location, const glm::mat4 &value) const
+{ 
+    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value)); 
 }
 
 #endif
@@ -0,0 +1,111 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Profiler.h"
+
+// 固定数量工作线程的任务池
+// 线程数为 0 时不创建线程，submit 直接在调用线程上执行任务（串行模式，便于做确定性对比）
+class ThreadPool {
+public:
+    explicit ThreadPool(int threadCount) : m_stop(false), m_active(0) {
+        for (int i = 0; i < threadCount; i++) {
+            m_workers.emplace_back([this, i]() { workerLoop(i); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wakeWorkers.notify_all();
+        for (std::thread& worker : m_workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // 默认线程数：留一个核心给主线程（渲染和 GPU 上传）
+    static int defaultThreadCount() {
+        int cores = (int)std::thread::hardware_concurrency();
+        return (cores > 1) ? cores - 1 : 1;
+    }
+
+    int threadCount() const { return (int)m_workers.size(); }
+
+    // urgent 为 true 时插到队首，排在所有尚未开始的任务之前（例如玩家编辑方块后的网格重建）
+    void submit(std::function<void()> task, bool urgent = false) {
+        if (m_workers.empty()) {
+            task();
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (urgent) {
+                m_tasks.push_front(std::move(task));
+            } else {
+                m_tasks.push_back(std::move(task));
+            }
+        }
+        m_wakeWorkers.notify_one();
+    }
+
+    // 等待队列中的任务全部执行完毕
+    void waitIdle() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_idle.wait(lock, [this]() { return m_tasks.empty() && m_active == 0; });
+    }
+
+    // 尚未开始执行的任务数
+    size_t queuedTasks() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_tasks.size();
+    }
+
+private:
+    void workerLoop(int index) {
+        Profiler::setThreadName("worker " + std::to_string(index));
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wakeWorkers.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+                if (m_stop && m_tasks.empty()) {
+                    return;
+                }
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+                m_active++;
+            }
+
+            task();
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_active--;
+                if (m_tasks.empty() && m_active == 0) {
+                    m_idle.notify_all();
+                }
+            }
+        }
+    }
+
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeWorkers;
+    std::condition_variable m_idle;
+    bool m_stop;
+    int m_active;
+};
+
+#endif
@@ -0,0 +1,449 @@
+#ifndef WORLD_STORAGE_H
+#define WORLD_STORAGE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Chunk.h"
+#include "ChunkMap.h"
+#include "Profiler.h"
+#include "RegionFile.h"
+
+// 存档方式
+enum SaveMode {
+    SAVE_FULL = 0,    // 保存区块的全部方块（走过的区块都写盘，读取时不必重新生成地形）
+    SAVE_DELTA = 1    // 只保存与生成的地形不同的方块（没编辑过的区块不写盘，读取时重新生成再应用修改）
+};
+
+// 读取存档的方式
+enum ReadMode {
+    READ_BUFFERED = 0,   // fseek + fread 到缓冲区（读写共用一个 FILE，读取时加锁）
+    READ_MMAP = 1        // 只读映射整个区域文件，区块数据直接从映射中解码（适合大量读取：飞越已有的世界、地图浏览）
+};
+
+// 一个区块的存档数据：自己持有的缓冲区，或者指向区域文件映射的内部（同时持有映射，保证解码期间有效）
+struct ChunkData {
+    std::vector<uint8_t> buffer;
+    std::shared_ptr<const RegionMapping> mapping;
+    const uint8_t* mapped = nullptr;
+    size_t mappedSize = 0;
+
+    const uint8_t* data() const { return (mapping != nullptr) ? mapped : buffer.data(); }
+    size_t size() const { return (mapping != nullptr) ? mappedSize : buffer.size(); }
+    bool empty() const { return size() == 0; }
+};
+
+// 世界存档：目录下每 32x32 个区块一个区域文件 r.<rx>.<rz>.region（第一次写入时创建）
+// 区块数据以 uint8 格式号开头，读取时两种格式都支持，与当前的存档方式无关：
+// - CHUNK_FORMAT_FULL：uint16 已分配段的位掩码, 然后每个已分配的段：
+//   uint16 调色板大小, 调色板 (uint16 x n), uint8 位宽, uint32 压缩后长度, 压缩后的打包下标
+//   打包下标就是 BlockStorage 内存中的数据（全石头的段位宽为 0，没有下标），再做一次字节游程压缩：
+//   地表以上的空气、成片的石头都是大段重复的字节。读取时直接还原，比 initData 便宜
+// - CHUNK_FORMAT_DELTA：uint32 修改数, 然后每个修改：uint16 区块内下标 (段号 * 4096 + BlockStorage 下标),
+//   uint16 方块类型。initData 只由区块坐标决定，读取时重新生成地形再依次写入这些方块
+// 增量存档时与地形相同的区块（包括编辑后又改回去的）不占存档空间
+// loadChunk/saveChunk 可以在任意线程调用（内部加锁）；游戏中通过 ChunkIO 在专门的 I/O 线程上调用
+class WorldStorage {
+public:
+    static constexpr uint8_t CHUNK_FORMAT_FULL = 1;
+    static constexpr uint8_t CHUNK_FORMAT_DELTA = 2;
+
+    explicit WorldStorage(const std::string& directory, SaveMode mode = SAVE_FULL, ReadMode readMode = READ_BUFFERED)
+        : m_directory(directory), m_mode(mode), m_readMode(readMode),
+          m_chunksLoaded(0), m_chunksSaved(0), m_bytesWritten(0) {
+        std::error_code error;
+        std::filesystem::create_directories(m_directory, error);
+    }
+
+    WorldStorage(const WorldStorage&) = delete;
+    WorldStorage& operator=(const WorldStorage&) = delete;
+
+    const std::string& directory() const { return m_directory; }
+    SaveMode saveMode() const { return m_mode; }
+    ReadMode readMode() const { return m_readMode; }
+
+    // 从存档读取区块（设置坐标和方块数据）；没有存档或数据损坏时返回 false，区块保持不变
+    bool loadChunk(Chunk& chunk, int chunkX, int chunkZ) {
+        ChunkData data;
+        return readChunkData(chunkX, chunkZ, data) && decodeChunk(data.data(), data.size(), chunkX, chunkZ, chunk);
+    }
+
+    // 只读取区块的存档数据（不解码，解码可以放到别的线程）；没有存档时返回 false
+    // READ_MMAP 时不复制数据，只在查找映射时加锁
+    bool readChunkData(int chunkX, int chunkZ, ChunkData& out) {
+        PROFILE_ZONE("WorldStorage::readChunkData");
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_readMode == READ_MMAP) {
+            std::shared_ptr<const RegionMapping> mapping = getMapping(chunkX, chunkZ);
+            if (mapping == nullptr) {
+                return false;
+            }
+            out.mapped = mapping->chunkData(regionLocal(chunkX), regionLocal(chunkZ), out.mappedSize);
+            if (out.mapped == nullptr) {
+                return false;
+            }
+            out.mapping = std::move(mapping);
+        } else {
+            RegionFile* region = getRegion(chunkX, chunkZ, false);
+            if (region == nullptr || !region->read(regionLocal(chunkX), regionLocal(chunkZ), out.buffer)) {
+                return false;
+            }
+        }
+        m_chunksLoaded++;
+        return true;
+    }
+
+    // 按当前存档方式编码；返回 false 表示不需要保存任何数据（增量存档时与地形相同）
+    bool encodeForSave(const Chunk& chunk, std::vector<uint8_t>& out) const {
+        if (m_mode == SAVE_FULL) {
+            encodeChunk(chunk, out);
+            return true;
+        }
+        if (!chunk.m_hasEdits || encodeDelta(chunk, out) == 0) {
+            out.clear();
+            return false;
+        }
+        return true;
+    }
+
+    // 保存区块并清除 m_needsSave；调用方保证期间没有其他线程修改这个区块
+    // 增量存档时没有修改的区块不写数据（已有的旧存档被删除）
+    // flush 为 false 时数据留在缓冲中，由之后的 syncAll 一起落盘（批量写入用）
+    bool saveChunk(Chunk& chunk, bool flush = true) {
+        PROFILE_ZONE("WorldStorage::saveChunk");
+        std::vector<uint8_t> data;
+        bool hasData = encodeForSave(chunk, data);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            int localX = regionLocal(chunk.m_chunkX);
+            int localZ = regionLocal(chunk.m_chunkZ);
+            // 文件内容要变了，旧的映射下次读取时重新建立（正在解码的线程仍持有旧映射）
+            m_mappings.erase(ChunkMap::packKey(regionCoord(chunk.m_chunkX), regionCoord(chunk.m_chunkZ)));
+            RegionFile* region = getRegion(chunk.m_chunkX, chunk.m_chunkZ, hasData);
+            if (hasData) {
+                if (region == nullptr || !region->write(localX, localZ, data.data(), data.size())) {
+                    return false;
+                }
+            } else if (region != nullptr && !region->erase(localX, localZ)) {
+                return false;
+            }
+            if (flush && region != nullptr) {
+                region->flush(false);
+            }
+        }
+        chunk.m_needsSave = false;
+        if (!hasData) {
+            chunk.m_hasEdits = false;   // 增量存档：编辑后又全部改回了原样
+            return true;
+        }
+        m_chunksSaved++;
+        m_bytesWritten += data.size();
+        return true;
+    }
+
+    // 所有有未落盘写入的区域文件 fsync 一次，返回 fsync 的次数
+    int syncAll() {
+        PROFILE_ZONE("WorldStorage::syncAll");
+        std::lock_guard<std::mutex> lock(m_mutex);
+        int syncs = 0;
+        for (auto& entry : m_regions) {
+            if (entry.second != nullptr && entry.second->flush(true)) {
+                syncs++;
+            }
+        }
+        return syncs;
+    }
+
+    // 统计
+    size_t chunksLoaded() const { return m_chunksLoaded; }
+    size_t chunksSaved() const { return m_chunksSaved; }
+    size_t bytesWritten() const { return m_bytesWritten; }
+
+    // 区块编码（不含区域文件的长度前缀）
+    static void encodeChunk(const Chunk& chunk, std::vector<uint8_t>& out) {
+        out.clear();
+        uint16_t mask = 0;
+        for (int s = 0; s < Chunk::SECTION_COUNT; s++) {
+            if (chunk.getSection(s) != nullptr) {
+                mask |= (uint16_t)(1u << s);
+            }
+        }
+        out.push_back(CHUNK_FORMAT_FULL);
+        writeValue(out, mask);
+
+        std::vector<uint8_t> packed;
+        for (int s = 0; s < Chunk::SECTION_COUNT; s++) {
+            const ChunkSection* section = chunk.getSection(s);
+            if (section == nullptr) {
+                continue;
+            }
+            const BlockStorage& blocks = section->blocks;
+            writeValue(out, (uint16_t)blocks.paletteSize());
+            for (uint16_t value : blocks.palette()) {
+                writeValue(out, value);
+            }
+            out.push_back((uint8_t)blocks.bitsPerBlock());
+            compressRuns((const uint8_t*)blocks.words().data(), blocks.words().size() * sizeof(uint64_t), packed);
+            writeValue(out, (uint32_t)packed.size());
+            out.insert(out.end(), packed.begin(), packed.end());
+        }
+    }
+
+    // 增量编码：与重新生成的地形逐段对比（调色板和打包数据完全相同的段直接跳过），返回修改数
+    static size_t encodeDelta(const Chunk& chunk, std::vector<uint8_t>& out) {
+        Chunk terrain;
+        terrain.initData(chunk.m_chunkX, chunk.m_chunkZ);
+
+        out.clear();
+        out.push_back(CHUNK_FORMAT_DELTA);
+        writeValue(out, (uint32_t)0);   // 修改数，最后回填
+        uint32_t count = 0;
+        for (int s = 0; s < Chunk::SECTION_COUNT; s++) {
+            const ChunkSection* section = chunk.getSection(s);
+            const ChunkSection* original = terrain.getSection(s);
+            if (section == nullptr && original == nullptr) {
+                continue;
+            }
+            if (section != nullptr && original != nullptr &&
+                section->blocks.palette() == original->blocks.palette() &&
+                section->blocks.words() == original->blocks.words()) {
+                continue;
+            }
+            for (int i = 0; i < BlockStorage::VOLUME; i++) {
+                uint16_t value = (section != nullptr) ? section->blocks.getIndex(i) : (uint16_t)BLOCK_AIR;
+                uint16_t originalValue = (original != nullptr) ? original->blocks.getIndex(i) : (uint16_t)BLOCK_AIR;
+                if (value != originalValue) {
+                    writeValue(out, (uint16_t)(s * BlockStorage::VOLUME + i));
+                    writeValue(out, value);
+                    count++;
+                }
+            }
+        }
+        std::memcpy(out.data() + 1, &count, sizeof(count));
+        return count;
+    }
+
+    // 区块解码（两种格式）：成功时替换区块的全部段并设置坐标，区块与存档一致（m_needsSave 为 false）
+    static bool decodeChunk(const uint8_t* data, size_t size, int chunkX, int chunkZ, Chunk& chunk) {
+        PROFILE_ZONE("WorldStorage::decodeChunk");
+        size_t pos = 0;
+        uint8_t format = 0;
+        if (!readValue(data, size, pos, format)) {
+            return false;
+        }
+        if (format == CHUNK_FORMAT_DELTA) {
+            return decodeDelta(data, size, pos, chunkX, chunkZ, chunk);
+        }
+        uint16_t mask = 0;
+        if (format != CHUNK_FORMAT_FULL || !readValue(data, size, pos, mask)) {
+            return false;
+        }
+
+        std::unique_ptr<ChunkSection> sections[Chunk::SECTION_COUNT];
+        for (int s = 0; s < Chunk::SECTION_COUNT; s++) {
+            if ((mask & (1u << s)) == 0) {
+                continue;
+            }
+            uint16_t paletteSize = 0;
+            if (!readValue(data, size, pos, paletteSize) || paletteSize == 0) {
+                return false;
+            }
+            std::vector<uint16_t> palette(paletteSize);
+            for (uint16_t& value : palette) {
+                if (!readValue(data, size, pos, value)) {
+                    return false;
+                }
+            }
+            uint8_t bits = 0;
+            uint32_t packedSize = 0;
+            if (!readValue(data, size, pos, bits) || !readValue(data, size, pos, packedSize) ||
+                packedSize > size - pos) {
+                return false;
+            }
+            // 直接解压到 BlockStorage 要用的数组里
+            size_t wordBytes = (size_t)BlockStorage::VOLUME * bits / 8;
+            std::vector<uint64_t> words(wordBytes / sizeof(uint64_t));
+            if (bits > 16 || !decompressRuns(data + pos, packedSize, (uint8_t*)words.data(), wordBytes)) {
+                return false;
+            }
+            pos += packedSize;
+
+            sections[s].reset(new ChunkSection());
+            if (!sections[s]->blocks.assignPacked(std::move(palette), bits, std::move(words))) {
+                return false;
+            }
+        }
+
+        for (int s = 0; s < Chunk::SECTION_COUNT; s++) {
+            chunk.m_sections[s] = std::move(sections[s]);
+        }
+        chunk.m_chunkX = chunkX;
+        chunk.m_chunkZ = chunkZ;
+        chunk.m_needsSave = false;
+        chunk.m_hasEdits = true;   // 完整存档不知道哪些方块被改过
+        return true;
+    }
+
+    // 区块坐标所在的区域坐标（向下取整）
+    static int regionCoord(int chunkCoord) {
+        const int R = RegionFile::REGION_SIZE;
+        return (chunkCoord >= 0) ? chunkCoord / R : (chunkCoord - R + 1) / R;
+    }
+
+    // 字节游程压缩（PackBits）：控制字节 0~127 表示后面 n+1 个字节原样复制，
+    // 129~255 表示下一个字节重复 257-n 次（2~128 次）
+    static void compressRuns(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+        out.clear();
+        size_t i = 0;
+        while (i < size) {
+            size_t run = 1;
+            while (i + run < size && run < 128 && data[i + run] == data[i]) {
+                run++;
+            }
+            if (run >= 2) {
+                out.push_back((uint8_t)(257 - run));
+                out.push_back(data[i]);
+                i += run;
+                continue;
+            }
+            // 原样复制，直到出现至少 2 个重复的字节
+            size_t literal = 1;
+            while (i + literal < size && literal < 128 &&
+                   !(i + literal + 1 < size && data[i + literal] == data[i + literal + 1])) {
+                literal++;
+            }
+            out.push_back((uint8_t)(literal - 1));
+            out.insert(out.end(), data + i, data + i + literal);
+            i += literal;
+        }
+    }
+
+    // 解压到 out；解压后的长度必须正好是 outSize
+    static bool decompressRuns(const uint8_t* data, size_t size, uint8_t* out, size_t outSize) {
+        size_t i = 0;
+        size_t written = 0;
+        while (i < size) {
+            uint8_t control = data[i++];
+            if (control < 128) {
+                size_t literal = (size_t)control + 1;
+                if (literal > size - i || literal > outSize - written) {
+                    return false;
+                }
+                std::memcpy(out + written, data + i, literal);
+                i += literal;
+                written += literal;
+            } else if (control > 128) {
+                size_t run = (size_t)(257 - control);
+                if (i >= size || run > outSize - written) {
+                    return false;
+                }
+                std::memset(out + written, data[i++], run);
+                written += run;
+            } else {
+                return false;
+            }
+        }
+        return written == outSize;
+    }
+
+private:
+    static bool decodeDelta(const uint8_t* data, size_t size, size_t pos, int chunkX, int chunkZ, Chunk& chunk) {
+        uint32_t count = 0;
+        if (!readValue(data, size, pos, count) || count > (size - pos) / 4) {
+            return false;
+        }
+        chunk.initData(chunkX, chunkZ);
+        for (uint32_t k = 0; k < count; k++) {
+            uint16_t index = 0;
+            uint16_t value = 0;
+            readValue(data, size, pos, index);
+            readValue(data, size, pos, value);
+            int i = index % BlockStorage::VOLUME;
+            int x = i / (BlockStorage::SIZE * BlockStorage::SIZE);
+            int y = (i / BlockStorage::SIZE) % BlockStorage::SIZE;
+            int z = i % BlockStorage::SIZE;
+            chunk.setBlock(x, (index / BlockStorage::VOLUME) * Chunk::CHUNK_SIZE + y, z, value);
+        }
+        chunk.m_needsSave = false;
+        chunk.m_hasEdits = count > 0;
+        return true;
+    }
+
+    static int regionLocal(int chunkCoord) {
+        return chunkCoord - regionCoord(chunkCoord) * RegionFile::REGION_SIZE;
+    }
+
+    // 区块所在区域文件的只读映射，调用方持有 m_mutex；文件不存在时返回 nullptr（同样记住，写入时清除）
+    std::shared_ptr<const RegionMapping> getMapping(int chunkX, int chunkZ) {
+        int regionX = regionCoord(chunkX);
+        int regionZ = regionCoord(chunkZ);
+        auto it = m_mappings.find(ChunkMap::packKey(regionX, regionZ));
+        if (it != m_mappings.end()) {
+            return it->second;
+        }
+        std::shared_ptr<RegionMapping> mapping(new RegionMapping());
+        if (!mapping->open(regionPath(regionX, regionZ))) {
+            mapping.reset();
+        }
+        m_mappings[ChunkMap::packKey(regionX, regionZ)] = mapping;
+        return mapping;
+    }
+
+    std::string regionPath(int regionX, int regionZ) const {
+        return m_directory + "/r." + std::to_string(regionX) + "." + std::to_string(regionZ) + ".region";
+    }
+
+    // 打开区块所在的区域文件，调用方持有 m_mutex
+    // 文件不存在时 create 为 true 则创建，否则返回 nullptr（并记住不存在，之后不再查询文件系统）
+    RegionFile* getRegion(int chunkX, int chunkZ, bool create) {
+        int regionX = regionCoord(chunkX);
+        int regionZ = regionCoord(chunkZ);
+        uint64_t key = ChunkMap::packKey(regionX, regionZ);
+        std::unique_ptr<RegionFile>& region = m_regions[key];
+        if (region != nullptr && region->isOpen()) {
+            return region.get();
+        }
+        if (region != nullptr && !create) {
+            return nullptr;
+        }
+        if (region == nullptr) {
+            region.reset(new RegionFile());
+        }
+        return region->open(regionPath(regionX, regionZ), create) ? region.get() : nullptr;
+    }
+
+    template <typename T>
+    static void writeValue(std::vector<uint8_t>& out, T value) {
+        uint8_t bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    template <typename T>
+    static bool readValue(const uint8_t* data, size_t size, size_t& pos, T& value) {
+        if (sizeof(T) > size - pos) {
+            return false;
+        }
+        std::memcpy(&value, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    std::string m_directory;
+    SaveMode m_mode;
+    ReadMode m_readMode;
+    std::mutex m_mutex;                                                 // 保护 m_regions 和区域文件
+    std::unordered_map<uint64_t, std::unique_ptr<RegionFile>> m_regions;   // 区域文件（ChunkMap::packKey），未打开的表示文件不存在
+    std::unordered_map<uint64_t, std::shared_ptr<const RegionMapping>> m_mappings;   // READ_MMAP 的映射，nullptr 表示文件不存在
+    std::atomic<size_t> m_chunksLoaded;
+    std::atomic<size_t> m_chunksSaved;
+    std::atomic<size_t> m_bytesWritten;
+};
+
+#endif
@@ -2,11 +2,22 @@
 #include <GLFW/glfw3.h>
 #include <iostream>
 #include <cmath>
-#include <map>
+#include <cstdlib>
+#include <string>
 #include "Shader.h"
 #include "Camera.h"
 #include "Chunk.h"
+#include "DayCycle.h"
+#include "ChunkIO.h"
+#include "ChunkMap.h"
+#include "ChunkPipeline.h"
+#include "ChunkStreamer.h"
+#include "Frustum.h"
+#include "MeshArena.h"
 #include "Player.h"
+#include "Profiler.h"
+#include "Raycast.h"
+#include "WorldStorage.h"
 #include <stb_image.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -16,12 +27,16 @@
 Camera camera(glm::vec3(0.0f, 20.0f, 0.0f));
 
 // 玩家对象（初始位置）
-Player player(glm::vec3(0.0f, 15.0f, 0.0f)); // 初始位置设在chunk顶部
+Player player(glm::vec3(0.0f, 80.0f, 0.0f)); // 初始位置设在地表上方
 
 // 时间相关变量
 float deltaTime = 0.0f; // 当前帧与上一帧的时间差
 float lastFrame = 0.0f; // 上一帧的时间
 
+// 昼夜循环：按住 T 时间加速 30 倍
+DayCycle dayCycle;
+const float DAY_FAST_FORWARD = 30.0f;
+
 // 鼠标相关变量
 float lastX = 400.0f;
 float lastY = 300.0f;
@@ -48,8 +63,55 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
     camera.ProcessMouseMovement(xoffset, yoffset);
 }
 
+// 鼠标点击在回调中记录，在主循环中处理：左键破坏方块，右键放置方块
+bool breakRequested = false;
+bool placeRequested = false;
+uint16_t placeBlockType = BLOCK_DIRT;   // 右键放置的方块：数字键 1 泥土，2 灯
+
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
+    if (action != GLFW_PRESS) {
+        return;
+    }
+    if (button == GLFW_MOUSE_BUTTON_LEFT) {
+        breakRequested = true;
+    } else if (button == GLFW_MOUSE_BUTTON_RIGHT) {
+        placeRequested = true;
+    }
+}
+
+// 性能分析：F8 开始/停止记录，F9 导出到 trace.json（用 chrome://tracing 或 ui.perfetto.dev 打开）
+// 环境变量 MYMC_PROFILE=1 时从启动开始记录，退出时有记录就自动导出
+const char* PROFILE_TRACE_PATH = "trace.json";
+bool profileToggleRequested = false;
+bool profileDumpRequested = false;
+
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    if (action != GLFW_PRESS) {
+        return;
+    }
+    if (key == GLFW_KEY_F8) {
+        profileToggleRequested = true;
+    } else if (key == GLFW_KEY_F9) {
+        profileDumpRequested = true;
+    } else if (key == GLFW_KEY_1) {
+        placeBlockType = BLOCK_DIRT;
+    } else if (key == GLFW_KEY_2) {
+        placeBlockType = BLOCK_LAMP;
+    }
+}
+
+void writeProfileTrace() {
+    long events = Profiler::writeChromeTrace(PROFILE_TRACE_PATH);
+    if (events < 0) {
+        std::cout << "Failed to write " << PROFILE_TRACE_PATH << std::endl;
+    } else {
+        std::cout << "Profile: " << events << " zones written to " << PROFILE_TRACE_PATH << std::endl;
+    }
+}
+
 void processInput(GLFWwindow *window)
 {
+    PROFILE_ZONE("processInput");
     if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
     
@@ -91,6 +153,12 @@ void processInput(GLFWwindow *window)
 }
 
 int main() {
+    const char* profileEnv = std::getenv("MYMC_PROFILE");
+    if (profileEnv != nullptr && profileEnv[0] != '\0' && profileEnv[0] != '0') {
+        Profiler::setEnabled(true);
+    }
+    Profiler::setThreadName("main");
+
     // 初始化 GLFW
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -110,6 +178,8 @@ int main() {
     // 设置鼠标输入模式：隐藏光标并捕获它
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
     glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
+    glfwSetKeyCallback(window, key_callback);
 
     // 初始化 GLAD (加载 OpenGL 函数指针)
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
@@ -120,22 +190,60 @@ int main() {
     // 创建着色器程序
     Shader ourShader("../src/shader.vs", "../src/shader.fs");
 
-    // 定义渲染范围（区块数量）
-    const int RENDER_DISTANCE = 8; // 渲染距离，生成 (2*8+1)^2 = 289 个区块
+    // 定义渲染范围（区块数量）：以玩家所在区块为中心的圆形加载半径
+    // 超出卸载半径的区块被释放；两者之间留出滞后区间，避免在边界附近反复加载/卸载
+    const int RENDER_DISTANCE = 8;
+    const int UNLOAD_DISTANCE = RENDER_DISTANCE + 2;
 
-    // 创建区块容器：使用 map 存储每个区块（按坐标索引）
-    std::map<std::pair<int, int>, Chunk*> chunks;
+    // 创建区块容器：哈希表存储每个区块（按坐标索引）
+    ChunkMap chunks;
     
-    // 预生成所有区块
-    for (int cx = -RENDER_DISTANCE; cx <= RENDER_DISTANCE; cx++) {
-        for (int cz = -RENDER_DISTANCE; cz <= RENDER_DISTANCE; cz++) {
-            Chunk* chunk = new Chunk();
-            chunk->initData(cx, cz);  // 使用区块坐标生成地形
-            chunk->updateMesh();
-            chunks[{cx, cz}] = chunk;
-        }
+    // 网格生成方式：MESH_GREEDY 合并相同贴图的面，MESH_NAIVE 为逐面网格（用于对比）
+    Chunk::s_meshMode = MESH_GREEDY;
+
+    // 区块生成/网格流水线：工作线程生成地形和顶点，主线程只负责上传
+    // 线程数设为 0 时在主线程上串行执行（用于确定性对比）
+    const int WORKER_THREADS = ThreadPool::defaultThreadCount();
+    ChunkPipeline pipeline(WORKER_THREADS);
+
+    // 世界存档：区块在卸载和退出时写入 world/ 下的区域文件
+    // 地形由区块坐标决定，增量存档只保存玩家改过的方块，再次进入时重新生成地形并应用修改
+    // 区域文件以只读映射读取，区块数据直接从映射中解码
+    WorldStorage worldStorage("world", SAVE_DELTA, READ_MMAP);
+    ChunkIO chunkIO(worldStorage);   // 存档读写都在 I/O 线程上进行
+
+    // 所有区块网格共用一个顶点缓冲，按页分配
+    MeshArena meshArena;
+    meshArena.init();
+
+    // 区块流式加载：随玩家移动由近到远加载、卸载区块
+    ChunkStreamer streamer(chunks, pipeline, &meshArena, RENDER_DISTANCE, UNLOAD_DISTANCE);
+    streamer.setIO(&chunkIO);
+
+    // 启动时不限时间预算，等出生点周围全部加载完成再进入主循环
+    double loadStart = glfwGetTime();
+    int spawnChunkX = ChunkStreamer::toChunkCoord(player.position.x);
+    int spawnChunkZ = ChunkStreamer::toChunkCoord(player.position.z);
+    streamer.setBudget(-1.0);
+    {
+        PROFILE_ZONE("startup load");
+        do {
+            streamer.update(spawnChunkX, spawnChunkZ);
+            pipeline.waitIdle();
+        } while (!streamer.isSettled());
+        streamer.update(spawnChunkX, spawnChunkZ);   // 取走最后一批网格结果并上传
     }
-    std::cout << "Generated " << chunks.size() << " chunks with Perlin noise terrain" << std::endl;
+    streamer.setBudget(0.004);                   // 之后每帧最多占用约 4ms
+    double loadTime = glfwGetTime() - loadStart;
+
+    size_t totalVertices = 0;
+    chunks.forEach([&](int cx, int cz, Chunk* chunk) {
+        totalVertices += chunk->vertexCount();
+    });
+    std::cout << "Loaded " << chunks.size() << " chunks with Perlin noise terrain in "
+              << loadTime * 1000.0 << " ms (" << pipeline.workerCount() << " worker threads)" << std::endl;
+    std::cout << "Meshed (" << (Chunk::s_meshMode == MESH_GREEDY ? "greedy" : "naive") << "): "
+              << totalVertices << " vertices" << std::endl;
 
     // 加载纹理图集 (Texture Atlas)
     unsigned int textureAtlas;
@@ -162,16 +270,29 @@ int main() {
 
     // 设置着色器中的纹理单元
     ourShader.use();
-    glUniform1i(glGetUniformLocation(ourShader.ID, "textureAtlas"), 0);
+    ourShader.setInt("textureAtlas", 0);
+    ourShader.setInt("chunkOrigins", 1);   // MeshArena 的页原点纹理缓冲
+
+    // 每帧都要设置的 uniform 位置只取一次（Shader 在链接时已缓存全部 uniform）
+    const int viewLoc = ourShader.getUniformLocation("view");
+    const int projectionLoc = ourShader.getUniformLocation("projection");
+    const int skyBrightnessLoc = ourShader.getUniformLocation("skyBrightness");
 
     // 启用深度测试
     glEnable(GL_DEPTH_TEST);
 
-    // 等待区块加载完成的标志
-    bool chunksLoaded = true;  // 区块已在主循环前生成完成
+    // 视锥剔除统计（每帧绘制/剔除的区块段数）
+    int sectionsDrawn = 0;
+    int sectionsCulled = 0;
+    float lastStatsTime = 0.0f;
+
+    // 选取方块的最远距离
+    const float REACH_DISTANCE = 8.0f;
+
 
     // 渲染循环
     while (!glfwWindowShouldClose(window)) {
+        PROFILE_ZONE("frame");
 
         // 计算deltaTime
         float currentFrame = glfwGetTime();
@@ -179,16 +300,55 @@ int main() {
         lastFrame = currentFrame;
 
         processInput(window);
+
+        // 时间只改变天空亮度 uniform 和背景色，不重建网格
+        dayCycle.advance(glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS ? deltaTime * DAY_FAST_FORWARD : deltaTime);
+
+        if (profileToggleRequested) {
+            Profiler::setEnabled(!Profiler::enabled());
+            std::cout << "Profiler " << (Profiler::enabled() ? "started" : "stopped") << std::endl;
+            profileToggleRequested = false;
+        }
+        if (profileDumpRequested) {
+            writeProfileTrace();
+            profileDumpRequested = false;
+        }
+
+        // 编辑准星指向的方块：左键破坏；右键放在命中面的外侧（不能放在玩家身体所在的位置）
+        // 受影响的段在 streamer.update 中优先重建，下一帧即可看到
+        if (breakRequested || placeRequested) {
+            PROFILE_ZONE("block edit");
+            RaycastHit target = raycastBlocks(chunks, camera.Position, camera.Front, REACH_DISTANCE);
+            if (target.hit && breakRequested) {
+                streamer.setBlock(target.block.x, target.block.y, target.block.z, BLOCK_AIR);
+            } else if (target.hit && placeRequested && target.normal != glm::ivec3(0)) {
+                glm::ivec3 place = target.block + target.normal;
+                AABB blockBox;
+                blockBox.min = glm::vec3(place);
+                blockBox.max = glm::vec3(place + 1);
+                if (!player.getAABB().intersects(blockBox)) {
+                    streamer.setBlock(place.x, place.y, place.z, placeBlockType);
+                }
+            }
+            breakRequested = false;
+            placeRequested = false;
+        }
+
+        // 流式加载：以玩家所在区块为中心加载/卸载区块、上传后台完成的网格（受每帧时间预算限制）
+        int playerChunkX = ChunkStreamer::toChunkCoord(player.position.x);
+        int playerChunkZ = ChunkStreamer::toChunkCoord(player.position.z);
+        streamer.update(playerChunkX, playerChunkZ);
         
-        // 只有在区块加载完成后才进行物理更新
-        if (chunksLoaded) {
+        // 只有在脚下区块加载完成后才进行物理更新（否则会掉进还没生成的区块）
+        if (chunks.contains(playerChunkX, playerChunkZ)) {
             player.update(deltaTime, chunks);
         }
         
         // 更新摄像机位置到玩家眼睛位置
         camera.Position = player.getEyePosition();
         
-        glClearColor(0.5f, 0.7f, 1.0f, 1.0f); // 天空蓝色背景
+        glm::vec3 skyColor = dayCycle.skyColor();
+        glClearColor(skyColor.r, skyColor.g, skyColor.b, 1.0f); // 天空背景随时间变化
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         
         // 使用Camera类获取视图矩阵
@@ -203,38 +363,93 @@ int main() {
         
         // 设置着色器
         ourShader.use();
-        unsigned int viewLoc = glGetUniformLocation(ourShader.ID, "view");
-        unsigned int projectionLoc = glGetUniformLocation(ourShader.ID, "projection");
-        unsigned int modelLoc = glGetUniformLocation(ourShader.ID, "model");
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
+        ourShader.setMat4(viewLoc, view);
+        ourShader.setMat4(projectionLoc, projection);
+        ourShader.setFloat(skyBrightnessLoc, dayCycle.skyBrightness());
         
-        // 绘制多个区块，形成无限延伸的效果
-        for (int cx = -RENDER_DISTANCE; cx <= RENDER_DISTANCE; cx++) {
-            for (int cz = -RENDER_DISTANCE; cz <= RENDER_DISTANCE; cz++) {
-                // 创建模型矩阵：平移到对应的区块位置
-                glm::mat4 model = glm::mat4(1.0f);
-                model = glm::translate(model, glm::vec3(cx * 16.0f, 0.0f, cz * 16.0f));
-                glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-                
-                // 渲染对应坐标的区块
-                auto it = chunks.find({cx, cz});
-                if (it != chunks.end()) {
-                    it->second->render();
+        // 视锥剔除：每帧从 projection * view 提取裁剪平面
+        Frustum frustum(projection * view);
+        sectionsDrawn = 0;
+        sectionsCulled = 0;
+        meshArena.beginFrame();
+
+        // 绘制所有已加载的区块（网格的生成和上传由 streamer 负责）
+        {
+            PROFILE_ZONE("cull sections");
+            chunks.forEach([&](int cx, int cz, Chunk* chunk) {
+                // 逐段处理：全空气的段没有分配，直接跳过
+                for (int s = 0; s < Chunk::SECTION_COUNT; s++) {
+                    ChunkSection* section = chunk->getSection(s);
+                    if (section == nullptr) {
+                        continue;
+                    }
+                    if (section->mesh.vertexCount == 0) {
+                        continue;   // 完全被包住的段（如地下全石头）没有可见面
+                    }
+
+                    // 段的包围盒完全在视锥外则跳过绘制
+                    glm::vec3 boxMin = chunk->sectionOrigin(s);
+                    glm::vec3 boxMax = boxMin + glm::vec3(16.0f);
+                    if (!frustum.intersectsAABB(boxMin, boxMax)) {
+                        sectionsCulled++;
+                        continue;
+                    }
+
+                    // 加入本帧的绘制列表（段原点由 MeshArena 按页记录，不再需要 model 矩阵）
+                    chunk->render(meshArena, s);
+                    sectionsDrawn++;
                 }
+            });
+        }
+
+        // 所有可见区块一次 glMultiDrawArrays 提交
+        {
+            PROFILE_ZONE("MeshArena::draw");
+            meshArena.draw(1);
+        }
+
+        // 每 0.5 秒在标题栏显示绘制/剔除的区块段数
+        if (currentFrame - lastStatsTime >= 0.5f) {
+            lastStatsTime = currentFrame;
+            std::string title = "Test | chunks loaded " + std::to_string(chunks.size()) +
+                                " | sections drawn " + std::to_string(sectionsDrawn) +
+                                " culled " + std::to_string(sectionsCulled);
+
+            // 准星指向的方块
+            RaycastHit target = raycastBlocks(chunks, camera.Position, camera.Front, REACH_DISTANCE);
+            if (target.hit) {
+                title += " | target " + std::to_string(target.block.x) + "," + std::to_string(target.block.y) +
+                         "," + std::to_string(target.block.z);
             }
+            glfwSetWindowTitle(window, title.c_str());
         }
 
-        glfwSwapBuffers(window);
+        {
+            PROFILE_ZONE("glfwSwapBuffers");
+            glfwSwapBuffers(window);
+        }
         glfwPollEvents();
 
     }
 
-    // 释放区块资源
-    for (auto& pair : chunks) {
-        delete pair.second;
+    // 释放区块资源（先等后台任务结束，它们可能还引用着区块）
+    streamer.shutdown();
+    std::cout << "Mesh uploads: " << meshArena.uploads() << " (" << meshArena.uploadsInPlace()
+              << " reused their pages)" << std::endl;
+    meshArena.destroy();
+    ChunkIO::Stats ioStats = chunkIO.stats();
+    std::cout << "World saved: " << worldStorage.chunksSaved() << " chunks, "
+              << worldStorage.bytesWritten() / 1024 << " KB written (" << worldStorage.chunksLoaded()
+              << " chunks loaded from disk)" << std::endl;
+    std::cout << "Chunk I/O: " << ioStats.loads << " loads (p50 " << ioStats.loadP50 << " ms, p99 "
+              << ioStats.loadP99 << " ms), " << ioStats.saves << " saves (p50 " << ioStats.saveP50
+              << " ms, p99 " << ioStats.saveP99 << " ms), " << ioStats.coalescedSaves << " coalesced, "
+              << ioStats.syncs << " fsyncs in " << ioStats.batches << " batches, max queue depth "
+              << ioStats.maxQueueDepth << std::endl;
+
+    if (Profiler::eventCount() > 0) {
+        writeProfileTrace();
     }
-    chunks.clear();
 
     glfwTerminate();
     return 0;
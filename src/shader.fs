@@ -2,10 +2,24 @@
 out vec4 FragColor;
 
 in vec2 TexCoord;
+flat in float TexIndex;
+in float Occlusion;      // 顶点的环境光遮蔽，在面内插值
+in float SkyLight;
+in float BlockLight;
 
 uniform sampler2D textureAtlas;
+// 昼夜循环的天空亮度（DayCycle::skyBrightness），只影响天空光；改变时不需要重建网格
+uniform float skyBrightness;
+
+// atlas中水平排列的贴图数量
+const float ATLAS_TILES = 4.0;
 
 void main()
 {
-   FragColor = texture(textureAtlas, TexCoord);
+   // TexCoord 以方块为单位，取小数部分让合并后的大面在贴图内平铺
+   vec2 local = fract(TexCoord);
+   vec2 atlasUV = vec2((TexIndex + local.x) / ATLAS_TILES, local.y);
+   vec4 color = texture(textureAtlas, atlasUV);
+   float light = max(SkyLight * skyBrightness, BlockLight);
+   FragColor = vec4(color.rgb * Occlusion * light, color.a);
 }
\ No newline at end of file
@@ -1,15 +1,54 @@
 #version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec2 aTexCoord;
+// 打包的顶点：bit 0-4 x, 5-9 y, 10-14 z, 15-17 面方向, 18-21 贴图索引, 22-23 环境光遮蔽,
+//           24-27 方块光, 28-31 天空光（见 Chunk.h）
+layout (location = 0) in uint aData;
 
-uniform mat4 model;
+// 每页顶点数，必须与 MeshArena::PAGE_VERTICES 一致
+const int PAGE_VERTICES = 256;
+
+// 每页所属区块的世界坐标原点（MeshArena 维护）
+uniform samplerBuffer chunkOrigins;
 uniform mat4 view;
 uniform mat4 projection;
 
+// 环境光遮蔽等级（0 最暗 ~ 3 不遮蔽）对应的亮度
+const float AO_BRIGHTNESS[4] = float[4](0.5, 0.7, 0.85, 1.0);
+
+// 光照等级（0 ~ 15）对应的亮度：每降一级乘 0.8
+float lightCurve(uint level)
+{
+   return pow(0.8, float(15u - level));
+}
+
 out vec2 TexCoord;
+flat out float TexIndex;
+out float Occlusion;    // 环境光遮蔽的亮度
+out float SkyLight;     // 天空光的亮度（未乘天空亮度，昼夜变化在片段着色器中处理）
+out float BlockLight;   // 方块光的亮度
 
 void main()
 {
-   gl_Position = projection * view * model * vec4(aPos, 1.0);
-   TexCoord = aTexCoord;
+   vec3 pos = vec3(float(aData & 31u),
+                   float((aData >> 5u) & 31u),
+                   float((aData >> 10u) & 31u));
+   uint face = (aData >> 15u) & 7u;
+
+   // 根据面方向从区块内坐标推导纹理坐标（以方块为单位），朝向与原先逐面 UV 一致
+   // face: 0=前, 1=后, 2=左, 3=右, 4=底, 5=顶
+   if (face <= 1u)
+      TexCoord = vec2(pos.x, pos.y);
+   else if (face == 2u)
+      TexCoord = vec2(pos.z, pos.y);
+   else if (face == 3u)
+      TexCoord = vec2(-pos.z, pos.y);
+   else
+      TexCoord = vec2(pos.x, -pos.z);
+
+   // glMultiDrawArrays 中 gl_VertexID = first + i，除以页大小即为所在页
+   vec3 origin = texelFetch(chunkOrigins, gl_VertexID / PAGE_VERTICES).xyz;
+   gl_Position = projection * view * vec4(origin + pos, 1.0);
+   TexIndex = float((aData >> 18u) & 15u);
+   Occlusion = AO_BRIGHTNESS[(aData >> 22u) & 3u];
+   SkyLight = lightCurve((aData >> 28u) & 15u);
+   BlockLight = lightCurve((aData >> 24u) & 15u);
 }
\ No newline at end of file